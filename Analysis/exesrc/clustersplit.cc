@@ -0,0 +1,54 @@
+#include <string>
+#include <vector>
+#include <iostream>
+
+#include <TFile.h>
+#include <TTree.h>
+
+#include <ChargedAnalysis/Utility/include/parser.h>
+#include <ChargedAnalysis/Utility/include/stringutil.h>
+#include <ChargedAnalysis/Utility/include/rootutil.h>
+#include <ChargedAnalysis/Utility/include/csv.h>
+
+int main(int argc, char *argv[]){
+    //Parser arguments
+    Parser parser(argc, argv);
+
+    std::vector<std::string> fileNames = parser.GetVector<std::string>("filenames");
+    std::string channel = parser.GetValue<std::string>("channel");
+    std::string outFile = parser.GetValue<std::string>("out-file");
+
+    long long nEvents = parser.GetValue<long long>("n-events", 0);
+    long long nBytes = parser.GetValue<long long>("n-bytes", 0);
+
+    if(nEvents <= 0 and nBytes <= 0) throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Either 'n-events' or 'n-bytes' has to be given!"));
+
+    //One row per proposed range, ranges are aligned to the basket clusters of the tree
+    CSV ranges(outFile, "w+", {"File", "Entries", "Clusters", "Start", "End"}, "\t");
+
+    for(const std::string& fileName : fileNames){
+        try{
+            std::shared_ptr<TFile> file = RUtil::Open(fileName);
+            TTree* tree = RUtil::Get<TTree>(file.get(), channel);
+
+            std::vector<long long> boundaries = RUtil::ClusterBoundaries(tree);
+
+            //Empty trees get one row without range, so they can be told apart from unreadable files
+            if(boundaries.back() == 0){
+                ranges.WriteRow(fileName, 0, 0, 0, 0);
+                std::cout << "File '" << fileName << "': empty tree, no ranges" << std::endl;
+                continue;
+            }
+
+            for(const std::pair<long long, long long>& range : RUtil::SplitByClusterSize(tree, nEvents, nBytes)){
+                ranges.WriteRow(fileName, boundaries.back(), boundaries.size() - 1, range.first, range.second);
+            }
+
+            std::cout << "File '" << fileName << "': " << boundaries.back() << " entries in " << boundaries.size() - 1 << " clusters, " << tree->GetZipBytes()/1e6 << " MB compressed" << std::endl;
+        }
+
+        catch(const std::exception& e){
+            std::cout << "Could not read file, which is skipped: " << fileName << std::endl;
+        }
+    }
+}
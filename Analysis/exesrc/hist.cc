@@ -16,11 +16,28 @@ int main(int argc, char* argv[]){
     int era = parser.GetValue<int>("era", 2017);
     int eventStart = parser.GetValue<int>("event-start");
     int eventEnd = parser.GetValue<int>("event-end");
+    int nThreads = parser.GetValue<int>("n-threads", 1);
 
-    std::vector<std::string> parameters = parser.GetVector("parameters");
-    std::vector<std::string> regions = parser.GetVector("regions");
-    if(regions.size() == 0) regions = {""};
-    std::vector<std::string> scaleSysts = parser.GetVector("scale-systs");
+    //Precompiled plan replaces parameters, regions, cuts and scale systematics
+    std::string planFile = parser.GetValue("plan", "");
+    AnalysisPlan plan;
+
+    if(planFile != "") plan = AnalysisPlan::Read(planFile);
+
+    else{
+        std::vector<std::string> parameters = parser.GetVector("parameters");
+        std::vector<std::string> regions = parser.GetVector("regions");
+        if(regions.size() == 0) regions = {""};
+        std::vector<std::string> scaleSysts = parser.GetVector("scale-systs");
+
+        std::map<std::string, std::vector<std::string>> cuts;
+
+        for(const std::string& region : regions){
+            cuts[region] = parser.GetVector(region + "-cuts");
+        }
+
+        plan = AnalysisPlan(parameters, regions, cuts, scaleSysts);
+    }
 
     std::string bkgYieldFac = parser.GetValue("bkg-yield-factor", "");
     std::vector<std::string> bkgYieldFacSyst = parser.GetVector("bkg-yield-factor-syst", {});
@@ -29,17 +46,21 @@ int main(int argc, char* argv[]){
     std::string fakeRate = parser.GetValue("fake-rate", "");
     std::string promptRate = parser.GetValue("prompt-rate", "");
 
-    std::map<std::string, std::string> outDir;
-    std::map<std::string, std::vector<std::string>> cuts, systDirs;
+    std::map<std::string, std::string> outDir, entryLists;
+    std::map<std::string, std::vector<std::string>> systDirs;
+    bool hasEntryLists = false;
 
-    for(const std::string& region : regions){
+    for(const std::string& region : plan.regions){
         outDir[region] = parser.GetValue(region + "-out-dir");
-
-        cuts[region] = parser.GetVector(region + "-cuts");
         systDirs[region] = parser.GetVector(region + "-syst-dirs");
+
+        //Passing entries written by treeIndex, only these entries are processed
+        entryLists[region] = parser.GetValue(region + "-entry-list", "");
+        if(entryLists[region] != "") hasEntryLists = true;
     }
 
     //Create treereader instance
-    HistMaker h(parameters, regions, cuts, outDir, outFile, channel, systDirs, scaleSysts, fakeRate, promptRate, era);
-    h.Produce(fileName, eventStart, eventEnd, bkgYieldFac, bkgType, bkgYieldFacSyst);
+    HistMaker h(plan, outDir, outFile, channel, systDirs, fakeRate, promptRate, era);
+    if(hasEntryLists) h.SetEntryLists(entryLists);
+    h.Produce(fileName, eventStart, eventEnd, bkgYieldFac, bkgType, bkgYieldFacSyst, nThreads);
 }
@@ -2,65 +2,66 @@
 #include <vector>
 
 #include <ChargedAnalysis/Analysis/include/ntuplereader.h>
-#include <ChargedAnalysis/Analysis/include/decoder.h>
+#include <ChargedAnalysis/Analysis/include/analysisplan.h>
+#include <ChargedAnalysis/Analysis/include/regionselector.h>
 #include <ChargedAnalysis/Utility/include/backtracer.h>
 #include <ChargedAnalysis/Utility/include/parser.h>
 #include <ChargedAnalysis/Utility/include/stringutil.h>
 #include <ChargedAnalysis/Utility/include/rootutil.h>
 #include <ChargedAnalysis/Utility/include/csv.h>
+#include <ChargedAnalysis/Utility/include/entryindex.h>
 
-void Loop(const std::string& fileName, const std::string& channel, const int& era, const std::vector<std::string> regions, const std::map<std::string, std::string>& outNames, const std::map<std::string, std::vector<std::string>>& cutStrings, const int& entryStart, const int& entryEnd){
-    Decoder parser;
+void Loop(const std::string& fileName, const std::string& channel, const int& era, const AnalysisPlan& plan, const std::map<std::string, std::string>& outNames, const int& entryStart, const int& entryEnd){
+    const std::vector<std::string>& regions = plan.regions;
 
     std::shared_ptr<TFile> inFile = RUtil::Open(fileName);
     std::shared_ptr<TTree> inTree = RUtil::GetSmart<TTree>(inFile.get(), channel);
 
     NTupleReader reader(inTree, era);
-    std::vector<NTupleFunction> cuts;
-    int nCuts = 0; std::vector<int> cutIdxRange;
+    RegionSelector selector;
 
+    //Binary index files are written at once at the end, CSV files row by row
     std::vector<std::unique_ptr<CSV>> outFiles;
+    std::vector<std::vector<long long>> passedEntries(regions.size());
+
     for(const std::string& region : regions){
-        outFiles.push_back(std::make_unique<CSV>(outNames.at(region), "w", std::vector<std::string>{"Index"}));
+        if(!EntryIndex::IsIndexName(outNames.at(region))) outFiles.push_back(std::make_unique<CSV>(outNames.at(region), "w", std::vector<std::string>{"Index"}));
+        else outFiles.push_back(nullptr);
     
         std::cout << std::endl << "Cuts for region '" << region << "'" << std::endl;
 
-        nCuts = 0;
+        std::size_t regionIdx = selector.AddRegion();
 
-        for(const std::string& cutString: cutStrings.at(region)){
+        for(const AnalysisPlan::Function& cutInfo: plan.cuts.at(region)){
             //Functor structure and arguments
-            NTupleFunction cut = reader.BuildFunc();
-                
-            parser.GetParticle(cutString, cut);
-            parser.GetFunction(cutString, cut);
-            parser.GetCut(cutString, cut);
-            cut.Compile();
+            NTupleFunction cut = AnalysisPlan::Build(cutInfo, reader);
 
-            cuts.push_back(cut);
-            ++nCuts;
+            selector.AddCut(regionIdx, cut);
 
             std::cout << "Cut will be applied: '" << cut.GetCutName() << "'" << std::endl;
         }
-
-        cutIdxRange.push_back(nCuts + (cutIdxRange.size() == 0 ? 0 : cutIdxRange.back()));
     }
 
-    bool passed = true;
+    //Only read branches needed by the cuts
+    reader.SetupCache(entryStart, entryEnd);
 
     for(int entry = entryStart; entry < entryEnd; ++entry){
         reader.SetEntry(entry);
+        selector.Evaluate();
 
         for(int region = 0; region < regions.size(); ++region){
-            passed = true;
+            if(!selector.Passed(region)) continue;
 
-            for(unsigned int j = region == 0 ? 0 : cutIdxRange[region-1]; j < cutIdxRange[region]; ++j){
-                passed = passed and cuts[j].GetPassed();
-                if(!passed) break;
-            }
-
-            if(passed) outFiles[region]->WriteRow(entry);
+            if(outFiles[region] != nullptr) outFiles[region]->WriteRow(entry);
+            else passedEntries[region].push_back(entry);
         }
     }
+
+    for(int region = 0; region < regions.size(); ++region){
+        if(outFiles[region] == nullptr) EntryIndex::Write(outNames.at(regions[region]), {fileName, channel, regions[region]}, passedEntries[region]);
+    }
+
+    selector.Report();
 }
 
 int main(int argc, char *argv[]){
@@ -78,15 +79,28 @@ int main(int argc, char *argv[]){
     int eventStart = parser.GetValue<int>("event-start");
     int eventEnd = parser.GetValue<int>("event-end");
 
-    std::vector<std::string> regions = parser.GetVector("regions");
+    //Precompiled plan replaces regions and cuts
+    std::string planFile = parser.GetValue("plan", "");
+    AnalysisPlan plan;
+
+    if(planFile != "") plan = AnalysisPlan::Read(planFile);
+
+    else{
+        std::vector<std::string> regions = parser.GetVector("regions");
+        std::map<std::string, std::vector<std::string>> cuts;
+
+        for(const std::string& region : regions){
+            cuts[region] = parser.GetVector(region + "-cuts");
+        }
+
+        plan = AnalysisPlan({}, regions, cuts, {});
+    }
 
     std::map<std::string, std::string> outDir;
-    std::map<std::string, std::vector<std::string>> cuts;
 
-    for(const std::string& region : regions){
+    for(const std::string& region : plan.regions){
         outDir[region] = parser.GetValue(region + "-out-dir") + "/" + outFile;
-        cuts[region] = parser.GetVector(region + "-cuts");
     }
 
-    Loop(fileName, channel, era, regions, outDir, cuts, eventStart, eventEnd);
+    Loop(fileName, channel, era, plan, outDir, eventStart, eventEnd);
 }
@@ -0,0 +1,26 @@
+#include <ChargedAnalysis/Utility/include/parser.h>
+#include <ChargedAnalysis/Analysis/include/analysisplan.h>
+
+int main(int argc, char* argv[]){
+    //Parser arguments
+    Parser parser(argc, argv);
+
+    std::string outFile = parser.GetValue<std::string>("out-file");
+
+    std::vector<std::string> parameters = parser.GetVector("parameters", {});
+    std::vector<std::string> regions = parser.GetVector("regions");
+    if(regions.size() == 0) regions = {""};
+    std::vector<std::string> scaleSysts = parser.GetVector("scale-systs", {});
+
+    std::map<std::string, std::vector<std::string>> cuts;
+
+    for(const std::string& region : regions){
+        cuts[region] = parser.GetVector(region + "-cuts");
+    }
+
+    //Decode everything once, hist/treeIndex jobs only read the plan file
+    AnalysisPlan plan(parameters, regions, cuts, scaleSysts);
+    plan.Write(outFile);
+
+    std::cout << "Wrote plan with " << plan.parameters.size() << " parameters and " << plan.regions.size() << " regions to '" << outFile << "'" << std::endl;
+}
@@ -0,0 +1,104 @@
+#ifndef ANALYSISPLAN_H
+#define ANALYSISPLAN_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <fstream>
+#include <cstdint>
+#include <experimental/source_location>
+
+#include <TH1.h>
+
+#include <ChargedAnalysis/Analysis/include/ntuplereader.h>
+#include <ChargedAnalysis/Analysis/include/weighter.h>
+#include <ChargedAnalysis/Utility/include/stringutil.h>
+#include <ChargedAnalysis/Utility/include/vectorutil.h>
+
+//Decoded parameters, cuts and regions of an analysis, which can be written once to a binary plan file and shared by all jobs
+class AnalysisPlan{
+    public:
+        struct Particle{
+            std::string alias, wp;
+            int idx = 0;
+        };
+
+        struct Function{
+            std::vector<Particle> particles;
+            std::string alias, cutOp;
+            std::vector<std::string> values;
+            std::vector<float> cutValues;
+            bool getSF = false;
+        };
+
+        struct Binning{
+            int nBins = 30;
+            float low = 0, high = 1;
+            std::vector<double> edges;
+        };
+
+        struct Parameter{
+            Function x, y;
+            bool hasY = false;
+            Binning xBins, yBins;
+        };
+
+        std::vector<std::string> regions, scaleSysts;
+        std::vector<Parameter> parameters;
+        std::map<std::string, std::vector<Function>> cuts;
+
+        AnalysisPlan(){}
+        AnalysisPlan(const std::vector<std::string>& parameters, const std::vector<std::string>& regions, const std::map<std::string, std::vector<std::string>>& cutStrings, const std::vector<std::string>& scaleSysts);
+
+        static AnalysisPlan Read(const std::string& fileName, const std::experimental::source_location& location = std::experimental::source_location::current());
+        void Write(const std::string& fileName, const std::experimental::source_location& location = std::experimental::source_location::current()) const;
+
+        //Bind decoded function/particle weights against the tree of the reader
+        static NTupleFunction Build(const Function& function, NTupleReader& reader);
+        static void AddWeights(const Function& function, NTupleReader& reader, Weighter& weight);
+
+        static void SetBins(TH1* hist, const Binning& xBins);
+        static void SetBins(TH1* hist, const Binning& xBins, const Binning& yBins);
+
+    private:
+        static constexpr std::uint32_t version = 1;
+
+        static void WriteValue(std::ofstream& out, const std::string& value);
+        static void WriteValue(std::ofstream& out, const Particle& value);
+        static void WriteValue(std::ofstream& out, const Function& value);
+        static void WriteValue(std::ofstream& out, const Binning& value);
+        static void WriteValue(std::ofstream& out, const Parameter& value);
+
+        template <typename T>
+        static void WriteValue(std::ofstream& out, const T& value){
+            out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        static void WriteValue(std::ofstream& out, const std::vector<T>& values){
+            WriteValue(out, std::uint64_t(values.size()));
+            for(const T& value : values) WriteValue(out, value);
+        }
+
+        static std::uint64_t ReadSize(std::ifstream& in);
+
+        static void ReadValue(std::ifstream& in, std::string& value);
+        static void ReadValue(std::ifstream& in, Particle& value);
+        static void ReadValue(std::ifstream& in, Function& value);
+        static void ReadValue(std::ifstream& in, Binning& value);
+        static void ReadValue(std::ifstream& in, Parameter& value);
+
+        template <typename T>
+        static void ReadValue(std::ifstream& in, T& value){
+            in.read(reinterpret_cast<char*>(&value), sizeof(T));
+            if(!in) throw std::runtime_error("File is truncated");
+        }
+
+        template <typename T>
+        static void ReadValue(std::ifstream& in, std::vector<T>& values){
+            values.resize(ReadSize(in));
+            for(T& value : values) ReadValue(in, value);
+        }
+};
+
+#endif
@@ -8,6 +8,7 @@
 
 #include <ChargedAnalysis/Analysis/include/ntuplereader.h>
 #include <ChargedAnalysis/Analysis/include/weighter.h>
+#include <ChargedAnalysis/Analysis/include/analysisplan.h>
 
 class Decoder{
     public:
@@ -15,6 +16,12 @@ class Decoder{
 
         bool hasYInfo(const std::string& parameter);
 
+        //Decode parameter/cut string into typed plan information
+        std::vector<AnalysisPlan::Particle> DecodeParticles(const std::string& parameter, const bool& readY = false, const std::experimental::source_location& location = std::experimental::source_location::current());
+        AnalysisPlan::Function DecodeFunction(const std::string& parameter, const bool& readY = false, const std::experimental::source_location& location = std::experimental::source_location::current());
+        AnalysisPlan::Binning DecodeBinning(const std::string& parameter, const bool& isY = false, const std::experimental::source_location& location = std::experimental::source_location::current());
+        void DecodeCut(const std::string& parameter, AnalysisPlan::Function& function, const std::experimental::source_location& location = std::experimental::source_location::current());
+
         void GetFunction(const std::string& parameter, NTupleFunction& func, const bool& readY = false, const std::experimental::source_location& location = std::experimental::source_location::current());
         void GetParticle(const std::string& parameter, NTupleFunction& func, const bool& readY = false, const std::experimental::source_location& location = std::experimental::source_location::current());
         void GetParticle(const std::string& parameter, NTupleReader& reader, Weighter& weight, const bool& readY = false, const std::experimental::source_location& location = std::experimental::source_location::current());
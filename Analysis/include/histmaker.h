@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <thread>
+#include <exception>
 #include <unordered_map>
 #include <experimental/source_location>
 
@@ -15,8 +17,12 @@
 
 #include <ChargedAnalysis/Analysis/include/ntuplereader.h>
 #include <ChargedAnalysis/Analysis/include/weighter.h>
-#include <ChargedAnalysis/Analysis/include/decoder.h>
+#include <ChargedAnalysis/Analysis/include/regionselector.h>
+#include <ChargedAnalysis/Analysis/include/analysisplan.h>
 #include <ChargedAnalysis/Utility/include/csv.h>
+#include <ChargedAnalysis/Utility/include/entryindex.h>
+#include <ChargedAnalysis/Utility/include/histaccumulator.h>
+#include <ChargedAnalysis/Utility/include/ratetable.h>
 #include <ChargedAnalysis/Utility/include/stopwatch.h>
 #include <ChargedAnalysis/Utility/include/stringutil.h>
 #include <ChargedAnalysis/Utility/include/rootutil.h>
@@ -24,15 +30,17 @@
 
 class HistMaker {
     private:
-        std::vector<std::string> regions, parameters, scaleSysts;
+        AnalysisPlan plan;
+        std::vector<std::string> regions, scaleSysts;
         std::map<std::string, std::string> outDir;
         std::string outFile, channel, fakeRateFile, promptRateFile;
-        std::map<std::string, std::vector<std::string>> cutStrings, systDirs;
+        std::map<std::string, std::vector<std::string>> systDirs;
         int era;
-        bool isMisIDJ;
+        bool isMisIDJ, isWorker = false;
 
         std::shared_ptr<TFile> inputFile;
         std::shared_ptr<TTree> inputTree;
+        std::shared_ptr<NTupleReader> reader;
 
         std::vector<std::shared_ptr<TFile>> outFiles, outFilesForMisIDJ;
         std::vector<std::shared_ptr<TH1F>> hists1D, hists1DMisIDJ, hists1DSystUp, hists1DSystDown;
@@ -42,17 +50,59 @@ class HistMaker {
         std::vector<int> cutIdxRange;
         std::vector<NTupleFunction> hist1DFunctions, cutFunctions;
         std::vector<std::pair<NTupleFunction, NTupleFunction>> hist2DFunctions;
+        RegionSelector selector;
+
+        //Sorted passing entries of each region from treeIndex, if given the cuts are not evaluated again
+        std::vector<std::vector<long long>> entryLists;
 
         Weighter baseWeight;
         std::unordered_map<int, Weighter> cutPartWeight, histPartWeight;
 
+        //Fill plan, each weight slot is one (syst, shift, region) combination with the index of its particle weight variation
+        struct WeightSlot{
+            std::size_t region;
+            bool isMisIDJ;
+            std::string baseShift;
+            std::vector<std::pair<Weighter*, std::size_t>> cutWeights;
+        };
+
+        struct FillTarget{
+            std::size_t value, weight;
+            bool partWeight;
+            std::size_t accumulator;
+        };
+
+        std::vector<WeightSlot> weightSlots;
+        std::vector<Weighter*> histWeights;
+        std::vector<FillTarget> countPlan, fill1DPlan, fill2DPlan;
+
+        //Histograms are filled in dense accumulators, bins are found once for each function
+        std::vector<HistAxis> axes1D;
+        std::vector<std::pair<HistAxis, HistAxis>> axes2D;
+        std::vector<HistAccumulator> accumulators;
+        std::vector<TH1*> accumulatedHists;
+
+        //Data driven scale factors and QCD estimation
+        float bkgY = 1.;
+        std::vector<float> bkgYUp, bkgYDown;
+        RateTable promptRate, fakeRate;
+        std::shared_ptr<NTupleFunction> lPt, lEta;
+
         void PrepareHists(const std::shared_ptr<TFile>& inFile, const std::shared_ptr<TTree> inTree, NTupleReader& reader, const std::experimental::source_location& location = std::experimental::source_location::current());
 
+        void CompileFillPlan();
+        void Book(const std::string& fileName, const std::string& bkgYieldFac, const std::string& bkgType, const std::vector<std::string>& bkgYieldFacSyst);
+        void Loop(const int& eventStart, const int& eventEnd);
+        void Add(const HistMaker& worker);
+        void Write();
+
     public:
         HistMaker();
         HistMaker(const std::vector<std::string>& parameters, const std::vector<std::string>& regions, const std::map<std::string, std::vector<std::string>>& cutStrings, const std::map<std::string, std::string>& outDir, const std::string& outFile, const std::string &channel, const std::map<std::string, std::vector<std::string>>& systDirs, const std::vector<std::string>& scaleSysts, const std::string& fakeRateFile, const std::string& promptRateFile, const int& era = 2017);
+        HistMaker(const AnalysisPlan& plan, const std::map<std::string, std::string>& outDir, const std::string& outFile, const std::string &channel, const std::map<std::string, std::vector<std::string>>& systDirs, const std::string& fakeRateFile, const std::string& promptRateFile, const int& era = 2017);
 
-        void Produce(const std::string& fileName, const int& eventStart, const int& eventEnd, const std::string& bkgYieldFac = "", const std::string& bkgType = "", const std::vector<std::string>& bkgYieldFacSyst = {});
+        void SetEntryLists(const std::map<std::string, std::string>& entryListFiles, const std::experimental::source_location& location = std::experimental::source_location::current());
+        void Produce(const std::string& fileName, const int& eventStart, const int& eventEnd, const std::string& bkgYieldFac = "", const std::string& bkgType = "", const std::vector<std::string>& bkgYieldFacSyst = {}, const int& nThreads = 1);
 };
 
 #endif
@@ -0,0 +1,42 @@
+#ifndef NTUPLECONFIG_H
+#define NTUPLECONFIG_H
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include <string>
+#include <cstdlib>
+#include <unordered_map>
+
+#include <ChargedAnalysis/Utility/include/stringutil.h>
+
+namespace pt = boost::property_tree;
+
+//Immutable content of particle.json and function.json, read once per process and shared by all readers
+class NTupleConfig{
+    private:
+        pt::ptree partInfo;
+        pt::ptree funcInfo;
+
+        //Alias -> name of child tree with this alias
+        std::unordered_map<std::string, std::string> partNames, funcNames;
+
+        NTupleConfig();
+
+        static void IndexAliases(const pt::ptree& node, std::unordered_map<std::string, std::string>& names);
+
+    public:
+        NTupleConfig(const NTupleConfig&) = delete;
+        NTupleConfig& operator=(const NTupleConfig&) = delete;
+
+        static const NTupleConfig& Get();
+
+        const pt::ptree& GetPartInfo() const {return partInfo;}
+        const pt::ptree& GetFuncInfo() const {return funcInfo;}
+
+        //Empty string if alias is unknown
+        std::string GetPartName(const std::string& alias) const;
+        std::string GetFuncName(const std::string& alias) const;
+};
+
+#endif
@@ -5,35 +5,67 @@
 #include <boost/property_tree/json_parser.hpp>
 
 #include <iostream>
+#include <algorithm>
 #include <vector>
 #include <memory>
 #include <functional>
 #include <string>
+#include <limits>
+#include <map>
+#include <deque>
+#include <tuple>
 #include <experimental/source_location>
 
 #include <TTree.h>
+#include <TChain.h>
+#include <TEntryList.h>
 #include <TLeaf.h>
 #include <TMath.h>
 #include <Math/Vector4D.h>
 
+#include <ChargedAnalysis/Analysis/include/ntupleconfig.h>
 #include <ChargedAnalysis/Utility/include/stringutil.h>
 #include <ChargedAnalysis/Utility/include/vectorutil.h>
 #include <ChargedAnalysis/Utility/include/rootutil.h>
+#include <ChargedAnalysis/Utility/include/mathutil.h>
 
 namespace pt = boost::property_tree;
 
-using Func = std::function<float(const int&, const int&)>;
+class NTupleReader;
+class NTupleCursor;
+
+using Func = std::function<float(NTupleCursor&, const int&)>;
 using Cut = std::function<bool(const float&)>;
 
-class NTupleReader;
+//Typed particle information with resolved working point, compiled once per particle/WP/index by the reader
+struct PartInfo{
+    std::string name, prefix, size, histName, axisName;
+    std::size_t idx = 0, hash = 0;
+
+    //Identification cuts of the working point as branch name, compare operator and value
+    std::vector<std::tuple<std::string, std::string, float>> identification;
+    const pt::ptree* requirements = nullptr;
+};
+
+//Typed function information, compiled once per alias or branch name by the reader
+struct FuncInfo{
+    std::string alias, branch, histName, axisName;
+    std::vector<std::string> need;
+    bool isCustom = false;
+};
 
 class NTupleFunction {
     friend class NTupleReader;
 
     private:
-        pt::ptree function;
-        std::vector<pt::ptree> particles;
-        std::size_t mainIdx;
+        const FuncInfo* function = nullptr;
+        std::vector<const PartInfo*> particles;
+        std::vector<std::string> values;
+        std::string cutOp;
+        std::vector<float> cutValues;
+
+        std::size_t mainIdx, funcSlot;
+        std::string signature, histName, axisName, cutName;
 
         bool isCompiled = false, isValid = true;
         Func func;
@@ -42,9 +74,6 @@ class NTupleFunction {
         NTupleReader* reader;
         NTupleFunction(NTupleReader* reader) : reader(reader) {}
 
-        Func compileBranchReading(const pt::ptree& part);
-        Func compileCustomFunction(const std::vector<pt::ptree>& parts);
-
     public:
         NTupleFunction() = delete;
 
@@ -54,74 +83,174 @@ class NTupleFunction {
         void AddCut(const float& value, const std::string& op, const std::experimental::source_location& location = std::experimental::source_location::current());
         void AddCut(const std::vector<float>& values, const std::string& op, const std::experimental::source_location& location = std::experimental::source_location::current());
 
+        //Evaluation with the default cursor of the reader
         float Get();
         float Get(const std::size_t& idx);
         bool GetPassed();
         bool GetPassed(const std::size_t& idx);
 
+        //Evaluation with own cursor, safe to call from several threads with one cursor per thread
+        float Get(NTupleCursor& cursor) const;
+        float Get(NTupleCursor& cursor, const std::size_t& idx) const;
+        bool GetPassed(NTupleCursor& cursor) const;
+        bool GetPassed(NTupleCursor& cursor, const std::size_t& idx) const;
+
         std::string GetHistName();
         std::string GetAxisLabel();
         std::string GetCutName();
+        std::string GetSignature();
 
         void Compile(const std::experimental::source_location& location = std::experimental::source_location::current());
 };
 
+//Per-thread evaluation state of a compiled reader: current entry, bound leafs, object selection and memoized values
+class NTupleCursor {
+    friend class NTupleReader;
+    friend class NTupleFunction;
+
+    private:
+        const NTupleReader* reader = nullptr;
+
+        std::size_t entry = 0;
+
+        //Trees with identical layout sharing the compiled functions, leafs are bound lazily per tree
+        TTree* inputTree = nullptr;
+        std::vector<TTree*> trees;
+        std::vector<std::vector<TLeaf*>> treeLeafs;
+        std::size_t treeIdx = 0;
+
+        //Local entry in the current file of a TChain, leafs are rebound on file transitions
+        bool isChain = false;
+        int treeNumber = -1;
+        std::size_t loadedEntry = std::numeric_limits<std::size_t>::max(), treeEntry = 0;
+
+        //Typed buffer of a bound leaf, loaded at most once per entry
+        struct LeafBuffer{
+            std::string name;
+            TLeaf* leaf;
+            bool isFloat;
+            std::vector<float> buffer;
+
+            const float* data = nullptr;
+            std::size_t size = 0;
+            std::size_t entry = std::numeric_limits<std::size_t>::max();
+        };
+
+        std::vector<LeafBuffer> leafBuffers;
+
+        //Selected objects for each particle slot of the reader
+        std::vector<std::vector<std::size_t>> selectedIdx;
+        std::vector<std::size_t> selectedEntry;
+
+        //Memoized value for each shared function slot of the reader
+        std::vector<std::size_t> sharedEntry;
+        std::vector<float> sharedValues;
+
+        void Sync();
+        void RebindLeaf(LeafBuffer& leaf, TTree* tree);
+        void LoadEntry(const std::size_t& entry, const std::experimental::source_location& location = std::experimental::source_location::current());
+        void Invalidate();
+
+        float GetShared(const std::size_t& funcSlot);
+
+    public:
+        NTupleCursor(){}
+        NTupleCursor(const NTupleReader& reader, const std::shared_ptr<TTree>& inputTree) : NTupleCursor(reader, std::vector<std::shared_ptr<TTree>>{inputTree}){}
+        NTupleCursor(const NTupleReader& reader, const std::vector<std::shared_ptr<TTree>>& inputTrees, const std::experimental::source_location& location = std::experimental::source_location::current());
+
+        void SetEntry(const std::size_t& entry);
+        void SetTree(const std::size_t& treeIdx);
+        void SetupCache(const std::size_t& entryStart, const std::size_t& entryEnd, const std::vector<std::string>& extraBranches = {}, const long long& cacheSize = 100000000);
+        void SetEntryList(const std::vector<long long>& entries);
+
+        const LeafBuffer& LoadLeaf(const std::size_t& leafSlot);
+
+        float GetValue(const std::size_t& leafSlot, const std::size_t& idx){
+            const LeafBuffer& leaf = LoadLeaf(leafSlot);
+            return idx < leaf.size ? leaf.data[idx] : -999.;
+        }
+
+        const std::vector<std::size_t>& SelectParticles(const std::size_t& partSlot);
+        std::size_t GetWPIndex(const std::size_t& partSlot, const std::size_t& idx);
+};
+
+//Compiled plan of functions, cuts and particle selections, immutable and shareable between threads after compiling
 class NTupleReader {
     friend class NTupleFunction;
+    friend class NTupleCursor;
 
     private:
-        pt::ptree partInfo;
-        pt::ptree funcInfo;
+        const NTupleConfig* config = nullptr;
+
+        //Compiled particle and function information, deques keep references stable while growing
+        std::deque<PartInfo> partInfos;
+        std::map<std::tuple<std::string, std::string, std::size_t, bool>, std::size_t> partIDs;
+        std::deque<FuncInfo> funcInfos;
+        std::map<std::pair<std::string, bool>, std::size_t> funcIDs;
 
-        TTree* inputTree;
         std::string chanPrefix;
         std::size_t era;
 
-        std::size_t entry;
-        std::map<std::pair<std::size_t, std::size_t>, std::size_t> idxCache;
+        std::map<std::string, std::size_t> leafSlots;
+        std::vector<std::string> leafNames;
+
+        //Object selection, one slot for each registered particle with requirements
+        std::map<std::size_t, std::size_t> partSlots;
+        std::vector<std::size_t> partSize;
+        std::vector<std::vector<std::pair<Cut, Func>>> partRequirements;
+
+        //Registry of compiled functions shared by their signature
+        std::map<std::string, std::size_t> funcSlots;
+        std::vector<Func> sharedFuncs;
+        std::vector<std::size_t> sharedIdx;
 
-        std::map<std::size_t, TLeaf*> partSize;
-        std::map<std::size_t, std::vector<std::pair<Cut, Func>>> partRequirements;
+        //Cursor used by the single threaded interface, bound to the trees given to the constructor
+        NTupleCursor cursor;
+
+        std::size_t RegisterFunc(const std::string& signature, const Func& func, const std::size_t& idx);
 
         Cut CreateCut(const std::string& op, const float& compV);
         Cut CreateCut(const std::string& op, const std::vector<float>& compV);
-        Func CreateFunc(const std::string& branchName, const pt::ptree& part);
-        Func CreateCustomFunc(const std::string& customFunc, const std::vector<pt::ptree>& parts);
+        Func CreateFunc(const std::string& branchName, const PartInfo* part);
+        Func CreateCustomFunc(const FuncInfo& customFunc, const std::vector<const PartInfo*>& parts);
 
-        std::size_t GetWPIndex(const std::size_t& entry, const std::size_t& partHash, const std::size_t& idx);
+        std::size_t BindLeaf(const std::string& branchName);
+        std::size_t GetPartSlot(const std::size_t& partHash);
 
-        pt::ptree SetPartWP(const pt::ptree& part, const std::string& wp, const std::size_t& idx);
-        void RegisterParticle(const pt::ptree& part);
+        const PartInfo& CompilePart(const std::string& pName, const std::string& wp, const std::size_t& idx, const bool& isSelf = false);
+        const FuncInfo* CompileFunc(const std::string& fAlias);
+        const FuncInfo& CompileBranchFunc(const std::string& branchName);
+        void RegisterParticle(const PartInfo& part);
 
     public:
         NTupleReader(){}
         NTupleReader(const std::shared_ptr<TTree>& inputTree, const std::size_t& era = 2017) : 
-                    inputTree(inputTree.get()), 
-                    era(era), 
-                    chanPrefix(!StrUtil::Find(inputTree->GetName(), "Ele").empty() ? "Ele" : "Muon"){
+                    NTupleReader(std::vector<std::shared_ptr<TTree>>{inputTree}, era){}
+        NTupleReader(const std::vector<std::shared_ptr<TTree>>& inputTrees, const std::size_t& era = 2017, const std::experimental::source_location& location = std::experimental::source_location::current());
 
-                pt::json_parser::read_json(StrUtil::Merge(std::getenv("CHDIR"), "/ChargedAnalysis/Analysis/data/particle.json"), partInfo);
-                pt::json_parser::read_json(StrUtil::Merge(std::getenv("CHDIR"), "/ChargedAnalysis/Analysis/data/function.json"), funcInfo);
-        }
+        //Functions and cursors keep a pointer to the reader
+        NTupleReader(const NTupleReader&) = delete;
+        NTupleReader& operator=(const NTupleReader&) = delete;
 
         NTupleFunction BuildFunc(){return NTupleFunction(this);}
-        void SetEntry(const std::size_t& entry){
-            this->entry = entry;
-            idxCache.clear();
-        }
 
-        float NParticles(const std::size_t& entry, const std::size_t& pHash, TLeaf* pSize);
-        float HT(const std::size_t& entry, const std::size_t& jetHash, TLeaf* jetPt);
-        float diCharge(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* ch1, TLeaf* ch2);
-        float dPhi(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* phi1, TLeaf* phi2);
-        float dR(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* phi1, TLeaf* phi2, TLeaf* eta1, TLeaf* eta2);
-        float diMass(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* pt1, TLeaf* pt2, TLeaf* phi1, TLeaf* phi2, TLeaf* eta1, TLeaf* eta2);
-        float ModifiedEntry(const int& entry, TLeaf* evNr);
-        float isGenMatched(const int& entry, const std::size_t& p1Idx, const std::size_t& p1Hash, TLeaf* gID);
-        float diMT(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* pt1, TLeaf* pt2, TLeaf* phi1, TLeaf* phi2);
-        float dPhi3(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, const std::size_t& p3Hash, TLeaf* phi1, TLeaf* pt2, TLeaf* phi2, TLeaf* eta2, TLeaf* pt3, TLeaf* phi3, TLeaf* eta3);
-        float dR3(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, const std::size_t& p3Hash, TLeaf* phi1, TLeaf* eta1, TLeaf* pt2, TLeaf* phi2, TLeaf* eta2, TLeaf* pt3, TLeaf* phi3, TLeaf* eta3);
-        float LP(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p1Hash, TLeaf* pt1, TLeaf* ptMet, TLeaf* phi1, TLeaf* phiMet);
+        void SetupCache(const std::size_t& entryStart, const std::size_t& entryEnd, const std::vector<std::string>& extraBranches = {}, const long long& cacheSize = 100000000){cursor.SetupCache(entryStart, entryEnd, extraBranches, cacheSize);}
+        void SetEntry(const std::size_t& entry){cursor.SetEntry(entry);}
+        void SetTree(const std::size_t& treeIdx){cursor.SetTree(treeIdx);}
+        void SetEntryList(const std::vector<long long>& entries){cursor.SetEntryList(entries);}
+
+        float NParticles(NTupleCursor& cursor, const std::size_t& pSlot, const std::size_t& pSize) const;
+        float HT(NTupleCursor& cursor, const std::size_t& jetSlot, const std::size_t& jetPt) const;
+        float diCharge(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& ch1, const std::size_t& ch2) const;
+        float dPhi(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& phi1, const std::size_t& phi2) const;
+        float dR(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& phi1, const std::size_t& phi2, const std::size_t& eta1, const std::size_t& eta2) const;
+        float diMass(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& pt1, const std::size_t& pt2, const std::size_t& phi1, const std::size_t& phi2, const std::size_t& eta1, const std::size_t& eta2) const;
+        float ModifiedEntry(NTupleCursor& cursor, const std::size_t& evNr) const;
+        float isGenMatched(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p1Slot, const std::size_t& gID) const;
+        float diMT(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& pt1, const std::size_t& pt2, const std::size_t& phi1, const std::size_t& phi2) const;
+        float dPhi3(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& p3Slot, const std::size_t& phi1, const std::size_t& pt2, const std::size_t& phi2, const std::size_t& eta2, const std::size_t& pt3, const std::size_t& phi3, const std::size_t& eta3) const;
+        float dR3(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& p3Slot, const std::size_t& phi1, const std::size_t& eta1, const std::size_t& pt2, const std::size_t& phi2, const std::size_t& eta2, const std::size_t& pt3, const std::size_t& phi3, const std::size_t& eta3) const;
+        float LP(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p1Slot, const std::size_t& pt1, const std::size_t& ptMet, const std::size_t& phi1, const std::size_t& phiMet) const;
 
         //Helper function to get keys of ptree
         static std::vector<std::string> GetKeys(const pt::ptree& node){
@@ -168,4 +297,13 @@ class NTupleReader {
         }
 };
 
+inline float NTupleCursor::GetShared(const std::size_t& funcSlot){
+    if(sharedEntry[funcSlot] != entry){
+        sharedValues[funcSlot] = reader->sharedFuncs[funcSlot](*this, reader->sharedIdx[funcSlot]);
+        sharedEntry[funcSlot] = entry;
+    }
+
+    return sharedValues[funcSlot];
+}
+
 #endif
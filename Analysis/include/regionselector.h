@@ -0,0 +1,50 @@
+#ifndef REGIONSELECTOR_H
+#define REGIONSELECTOR_H
+
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdint>
+#include <chrono>
+#include <limits>
+#include <algorithm>
+#include <experimental/source_location>
+
+#include <ChargedAnalysis/Analysis/include/ntuplereader.h>
+#include <ChargedAnalysis/Utility/include/stringutil.h>
+
+class RegionSelector{
+    private:
+        //Unique cuts and the bitmask of regions requiring them
+        std::vector<NTupleFunction> cuts;
+        std::vector<std::uint64_t> cutRegions;
+        std::map<std::string, std::size_t> cutSlots;
+        std::vector<std::size_t> order;
+
+        //Rejection and evaluation time of each cut, measured for the first events to order the cuts
+        std::size_t nSample = 2000, nSampled = 0;
+        bool isOrdered = false;
+        std::vector<std::size_t> nEvaluated, nRejected, nTimed;
+        std::vector<double> evalTime;
+        std::uint64_t allRegions = 0;
+        std::size_t nRegions = 0;
+
+        //Bitmask of passed regions for the current entry
+        std::uint64_t passed = 0;
+
+    public:
+        RegionSelector(){}
+
+        std::size_t AddRegion(const std::experimental::source_location& location = std::experimental::source_location::current());
+        std::size_t AddCut(const std::size_t& region, NTupleFunction cut);
+
+        //Evaluate all cuts for the entry the reader of the cuts is set to
+        void Evaluate();
+        void Reorder();
+        void Report();
+
+        bool Passed(const std::size_t& region) const {return passed >> region & 1;}
+        bool AnyPassed() const {return passed != 0;}
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <array>
+#include <limits>
+#include <cmath>
 
 #include <TFile.h>
 #include <TTree.h>
@@ -15,6 +18,7 @@
 
 #include <ChargedAnalysis/Analysis/include/ntuplereader.h>
 #include <ChargedAnalysis/Utility/include/rootutil.h>
+#include <ChargedAnalysis/Utility/include/ratetable.h>
 #include <ChargedAnalysis/Utility/include/stringutil.h>
 
 namespace pt = boost::property_tree;
@@ -33,12 +37,30 @@ class Weighter{
         TLeaf* nPartons = nullptr;
 
         double nGen = 1., baseWeight = 1., partWeight = 1.;
-        std::shared_ptr<TH1F> pileUpWeight, pileUpWeightUp, pileUpWeightDown;
+        TLeaf* nTrueInt = nullptr;
+        std::vector<double> pileUpWeight, pileUpWeightUp, pileUpWeightDown;
+        std::size_t baseEntry = std::numeric_limits<std::size_t>::max();
+        std::array<double, 3> baseWeights;
         std::vector<NTupleFunction> sf, sfUp, sfDown;
-        std::function<float(const int&)> bWeight, bWeightUp, bWeightDown; 
-        std::vector<std::string> systematics;
 
-        static double GetBJetWeight(const int& entry, TH2F* effB, TH2F* effC, TH2F* effLight, NTupleFunction& bPt, TLeaf* pt, TLeaf* eta, TLeaf* sf, TLeaf* flavour);
+        //B-tag weights for nominal, Up and Down, calculated in one pass per entry
+        std::shared_ptr<NTupleFunction> bPt;
+        RateTable effB, effC, effLight;
+        TLeaf* jetPt = nullptr, *jetEta = nullptr, *partonFlav = nullptr;
+        std::array<TLeaf*, 3> bSF = {nullptr, nullptr, nullptr};
+        std::size_t bEntry = std::numeric_limits<std::size_t>::max();
+        std::array<double, 3> bWeights;
+        std::vector<float> bEff;
+        std::vector<bool> bTagged;
+
+        //Particle weights for all variations: nominal, Up/Down of each scale factor, Up/Down of b-tag
+        std::size_t partEntry = std::numeric_limits<std::size_t>::max();
+        std::vector<double> partWeights, sfPrefix, sfSuffix;
+        std::vector<std::array<double, 3>> sfProducts;
+
+        std::vector<std::string> systematics, branchNames;
+
+        void SetBJetWeights(const std::size_t& entry);
 
     public:
         Weighter();
@@ -47,9 +69,13 @@ class Weighter{
         void AddParticle(const std::string& partName, const std::string& wp, NTupleReader& reader, const std::experimental::source_location& location = std::experimental::source_location::current());
 
         int GetNWeights();
+        std::vector<std::string> GetBranchNames(){return branchNames;}
 
         double GetBaseWeight(const std::size_t& entry, const std::string& sysShift = "");
         double GetPartWeight(const std::size_t& entry, const std::string& syst = "", const std::string& sysShift = "");
+
+        std::size_t GetWeightIndex(const std::string& syst, const std::string& sysShift);
+        const std::vector<double>& GetPartWeights(const std::size_t& entry);
         double GetTotalWeight(const std::size_t& entry, const std::string& syst = "", const std::string& sysShift = "");
 };
 
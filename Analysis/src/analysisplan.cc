@@ -0,0 +1,217 @@
+#include <ChargedAnalysis/Analysis/include/analysisplan.h>
+#include <ChargedAnalysis/Analysis/include/decoder.h>
+
+AnalysisPlan::AnalysisPlan(const std::vector<std::string>& parameters, const std::vector<std::string>& regions, const std::map<std::string, std::vector<std::string>>& cutStrings, const std::vector<std::string>& scaleSysts) :
+    regions(regions),
+    scaleSysts(scaleSysts){
+
+    Decoder parser;
+
+    for(const std::string& parameter : parameters){
+        Parameter param;
+        param.x = parser.DecodeFunction(parameter);
+        param.xBins = parser.DecodeBinning(parameter);
+        param.hasY = parser.hasYInfo(parameter);
+
+        if(param.hasY){
+            param.y = parser.DecodeFunction(parameter, true);
+            param.yBins = parser.DecodeBinning(parameter, true);
+        }
+
+        this->parameters.push_back(std::move(param));
+    }
+
+    for(const std::string& region : regions){
+        cuts[region] = {};
+
+        for(const std::string& cutString : cutStrings.at(region)){
+            //Cut key is optional in DecodeFunction, decode it explicitly so a missing 'c:' fails here
+            AnalysisPlan::Function cut = parser.DecodeFunction(cutString);
+            parser.DecodeCut(cutString, cut);
+
+            cuts[region].push_back(std::move(cut));
+        }
+    }
+}
+
+void AnalysisPlan::Write(const std::string& fileName, const std::experimental::source_location& location) const {
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out) throw std::runtime_error(StrUtil::PrettyError(location, "Could not open plan file '", fileName, "' for writing!"));
+
+    out.write("CHPLAN", 6);
+    WriteValue(out, version);
+
+    WriteValue(out, regions);
+    WriteValue(out, scaleSysts);
+    WriteValue(out, parameters);
+
+    for(const std::string& region : regions) WriteValue(out, cuts.at(region));
+}
+
+AnalysisPlan AnalysisPlan::Read(const std::string& fileName, const std::experimental::source_location& location){
+    std::ifstream in(fileName, std::ios::binary);
+    if(!in) throw std::runtime_error(StrUtil::PrettyError(location, "Could not open plan file '", fileName, "'!"));
+
+    char magic[6];
+    std::uint32_t fileVersion = 0;
+
+    in.read(magic, 6);
+    in.read(reinterpret_cast<char*>(&fileVersion), sizeof(fileVersion));
+
+    if(!in or std::string(magic, 6) != "CHPLAN" or fileVersion != version){
+        throw std::runtime_error(StrUtil::PrettyError(location, "File '", fileName, "' is no plan file of version ", version, "!"));
+    }
+
+    AnalysisPlan plan;
+
+    try{
+        ReadValue(in, plan.regions);
+        ReadValue(in, plan.scaleSysts);
+        ReadValue(in, plan.parameters);
+
+        for(const std::string& region : plan.regions) ReadValue(in, plan.cuts[region]);
+    }
+
+    catch(const std::runtime_error& e){
+        throw std::runtime_error(StrUtil::PrettyError(location, "Plan file '", fileName, "' is corrupt: ", e.what(), "!"));
+    }
+
+    return plan;
+}
+
+NTupleFunction AnalysisPlan::Build(const Function& function, NTupleReader& reader){
+    NTupleFunction func = reader.BuildFunc();
+
+    for(const Particle& part : function.particles) func.AddParticle(part.alias, part.idx, part.wp);
+    func.AddFunction(function.alias, function.values);
+
+    if(function.cutValues.size() == 1) func.AddCut(function.cutValues.at(0), function.cutOp);
+    else if(function.cutValues.size() > 1) func.AddCut(function.cutValues, function.cutOp);
+
+    func.Compile();
+
+    return func;
+}
+
+void AnalysisPlan::AddWeights(const Function& function, NTupleReader& reader, Weighter& weight){
+    for(const Particle& part : function.particles) weight.AddParticle(part.alias, part.wp, reader);
+}
+
+void AnalysisPlan::SetBins(TH1* hist, const Binning& xBins){
+    if(xBins.edges.empty()) hist->SetBins(xBins.nBins, xBins.low, xBins.high);
+    else hist->SetBins(xBins.edges.size() - 1, xBins.edges.data());
+}
+
+void AnalysisPlan::SetBins(TH1* hist, const Binning& xBins, const Binning& yBins){
+    if(xBins.edges.empty() and yBins.edges.empty()) hist->SetBins(xBins.nBins, xBins.low, xBins.high, yBins.nBins, yBins.low, yBins.high);
+
+    else{
+        std::vector<double> xEdges = !xBins.edges.empty() ? xBins.edges : VUtil::Range<double>(xBins.low, xBins.high, xBins.nBins + 1);
+        std::vector<double> yEdges = !yBins.edges.empty() ? yBins.edges : VUtil::Range<double>(yBins.low, yBins.high, yBins.nBins + 1);
+
+        hist->SetBins(xEdges.size() - 1, xEdges.data(), yEdges.size() - 1, yEdges.data());
+    }
+}
+
+void AnalysisPlan::WriteValue(std::ofstream& out, const std::string& value){
+    WriteValue(out, std::uint64_t(value.size()));
+    out.write(value.data(), value.size());
+}
+
+void AnalysisPlan::WriteValue(std::ofstream& out, const Particle& value){
+    WriteValue(out, value.alias);
+    WriteValue(out, value.wp);
+    WriteValue(out, std::int32_t(value.idx));
+}
+
+void AnalysisPlan::WriteValue(std::ofstream& out, const Function& value){
+    WriteValue(out, value.particles);
+    WriteValue(out, value.alias);
+    WriteValue(out, value.cutOp);
+    WriteValue(out, value.values);
+    WriteValue(out, value.cutValues);
+    WriteValue(out, std::uint8_t(value.getSF));
+}
+
+void AnalysisPlan::WriteValue(std::ofstream& out, const Binning& value){
+    WriteValue(out, std::int32_t(value.nBins));
+    WriteValue(out, value.low);
+    WriteValue(out, value.high);
+    WriteValue(out, value.edges);
+}
+
+void AnalysisPlan::WriteValue(std::ofstream& out, const Parameter& value){
+    WriteValue(out, value.x);
+    WriteValue(out, value.y);
+    WriteValue(out, std::uint8_t(value.hasY));
+    WriteValue(out, value.xBins);
+    WriteValue(out, value.yBins);
+}
+
+std::uint64_t AnalysisPlan::ReadSize(std::ifstream& in){
+    std::uint64_t size = 0;
+    ReadValue(in, size);
+
+    //Every element takes at least one byte, so a larger size can only come from a corrupt file
+    std::streampos pos = in.tellg();
+    in.seekg(0, std::ios::end);
+    std::uint64_t remaining = in.tellg() - pos;
+    in.seekg(pos);
+
+    if(size > remaining) throw std::runtime_error("Size " + std::to_string(size) + " exceeds remaining " + std::to_string(remaining) + " bytes");
+
+    return size;
+}
+
+void AnalysisPlan::ReadValue(std::ifstream& in, std::string& value){
+    value.resize(ReadSize(in));
+    in.read(value.data(), value.size());
+
+    if(!in) throw std::runtime_error("File is truncated");
+}
+
+void AnalysisPlan::ReadValue(std::ifstream& in, Particle& value){
+    std::int32_t idx = 0;
+
+    ReadValue(in, value.alias);
+    ReadValue(in, value.wp);
+    ReadValue(in, idx);
+
+    value.idx = idx;
+}
+
+void AnalysisPlan::ReadValue(std::ifstream& in, Function& value){
+    std::uint8_t getSF = 0;
+
+    ReadValue(in, value.particles);
+    ReadValue(in, value.alias);
+    ReadValue(in, value.cutOp);
+    ReadValue(in, value.values);
+    ReadValue(in, value.cutValues);
+    ReadValue(in, getSF);
+
+    value.getSF = getSF;
+}
+
+void AnalysisPlan::ReadValue(std::ifstream& in, Binning& value){
+    std::int32_t nBins = 0;
+
+    ReadValue(in, nBins);
+    ReadValue(in, value.low);
+    ReadValue(in, value.high);
+    ReadValue(in, value.edges);
+
+    value.nBins = nBins;
+}
+
+void AnalysisPlan::ReadValue(std::ifstream& in, Parameter& value){
+    std::uint8_t hasY = 0;
+
+    ReadValue(in, value.x);
+    ReadValue(in, value.y);
+    ReadValue(in, hasY);
+    ReadValue(in, value.xBins);
+    ReadValue(in, value.yBins);
+
+    value.hasY = hasY;
+}
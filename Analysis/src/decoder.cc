@@ -6,88 +6,75 @@ bool Decoder::hasYInfo(const std::string& parameter){
     return !StrUtil::Find(parameter, "ax=y").empty();
 }
 
-void Decoder::GetFunction(const std::string& parameter, NTupleFunction& func, const bool& readY, const std::experimental::source_location& location){
-    if(StrUtil::Find(parameter, "f:").empty()) throw std::runtime_error(StrUtil::PrettyError(location, "No function key 'f:' in '",  parameter, "'!"));
+std::vector<AnalysisPlan::Particle> Decoder::DecodeParticles(const std::string& parameter, const bool& readY, const std::experimental::source_location& location){
+    std::vector<AnalysisPlan::Particle> particles;
 
-    std::vector<std::string> lines = StrUtil::Split(parameter, "/");
-    lines.erase(std::remove_if(lines.begin(), lines.end(), [&](std::string l){return StrUtil::Find(l, "f:").empty();}), lines.end());
-    
-    for(const std::string& line : lines){
-        std::string funcName; std::vector<std::string> values; bool isY = false;
-
-        std::string funcLine = line.substr(line.find("f:")+2);
-        
-        for(std::string& funcParam: StrUtil::Split(funcLine, ",")){
-            std::vector<std::string> fInfo = funcParam != "" ? StrUtil::Split(funcParam, "=") : StrUtil::Split(funcLine, "=");
-
-            if(fInfo[0] == "n") funcName = fInfo[1];
-            else if(fInfo[0] == "v") values.push_back(fInfo[1]);
-            else if(fInfo[0] == "ax") isY = "y" == fInfo[1];
-            else throw std::runtime_error(StrUtil::PrettyError(location, "Invalid key '", fInfo[0], "' in parameter '", parameter, "'"));
-        }
-
-        if(isY == readY) func.AddFunction(funcName, values);
-    }
-}
-
-void Decoder::GetParticle(const std::string& parameter, NTupleFunction& func, const bool& readY, const std::experimental::source_location& location){
     std::vector<std::string> lines = StrUtil::Split(parameter, "/");
     lines.erase(std::remove_if(lines.begin(), lines.end(), [&](std::string l){return StrUtil::Find(l, "p:").empty();}), lines.end());
 
     for(const std::string line : lines){
         std::string partLine = line.substr(line.find("p:")+2);
-        std::string part = ""; std::string wp = ""; int idx = 0; bool isY = false;
+        AnalysisPlan::Particle part; bool isY = false;
 
         for(const std::string& partParam: StrUtil::Split(partLine, ",")){
             std::vector<std::string> pInfo = partParam != "" ? StrUtil::Split(partParam, "=") : StrUtil::Split(partLine, "=");
 
-            if(pInfo[0] == "n") part = pInfo[1];
-            else if (pInfo[0] == "wp") wp = pInfo[1];
-            else if (pInfo[0] == "i") idx = std::atoi(pInfo[1].c_str());
+            if(pInfo[0] == "n") part.alias = pInfo[1];
+            else if (pInfo[0] == "wp") part.wp = pInfo[1];
+            else if (pInfo[0] == "i") part.idx = std::atoi(pInfo[1].c_str());
             else if(pInfo[0] == "ax") isY = "y" == pInfo[1];
             else throw std::runtime_error(StrUtil::PrettyError(location, "Invalid key '", pInfo[0], "' in parameter '", parameter, "'"));
         }
 
-        if(isY == readY){
-            func.AddParticle(part, idx, wp);
-        }
+        if(isY == readY) particles.push_back(std::move(part));
     }
+
+    return particles;
 }
 
-void Decoder::GetParticle(const std::string& parameter, NTupleReader& reader, Weighter& weight, const bool& readY, const std::experimental::source_location& location){
-    std::vector<std::string> lines = StrUtil::Split(parameter, "/");
-    lines.erase(std::remove_if(lines.begin(), lines.end(), [&](std::string l){return StrUtil::Find(l, "p:").empty();}), lines.end());
+AnalysisPlan::Function Decoder::DecodeFunction(const std::string& parameter, const bool& readY, const std::experimental::source_location& location){
+    if(StrUtil::Find(parameter, "f:").empty()) throw std::runtime_error(StrUtil::PrettyError(location, "No function key 'f:' in '",  parameter, "'!"));
 
-    for(const std::string line : lines){
-        std::string partLine = line.substr(line.find("p:")+2);
+    AnalysisPlan::Function function;
+    function.particles = DecodeParticles(parameter, readY, location);
+    function.getSF = !readY and !StrUtil::Find(parameter, "getSF").empty();
 
-        std::string part = ""; std::string wp = ""; int idx = 0; bool isY = false;
+    std::vector<std::string> lines = StrUtil::Split(parameter, "/");
+    lines.erase(std::remove_if(lines.begin(), lines.end(), [&](std::string l){return StrUtil::Find(l, "f:").empty();}), lines.end());
+    
+    for(const std::string& line : lines){
+        std::string funcName; std::vector<std::string> values; bool isY = false;
 
-        for(const std::string& partParam: StrUtil::Split(partLine, ",")){
-            std::vector<std::string> pInfo = partParam != "" ? StrUtil::Split(partParam, "=") : StrUtil::Split(partLine, "=");
+        std::string funcLine = line.substr(line.find("f:")+2);
+        
+        for(std::string& funcParam: StrUtil::Split(funcLine, ",")){
+            std::vector<std::string> fInfo = funcParam != "" ? StrUtil::Split(funcParam, "=") : StrUtil::Split(funcLine, "=");
 
-            if(pInfo[0] == "n") part = pInfo[1];
-            else if (pInfo[0] == "wp") wp = pInfo[1];
-            else if (pInfo[0] == "i") idx = std::atoi(pInfo[1].c_str());
-            else if(pInfo[0] == "ax") isY = "y" == pInfo[1];
-            else throw std::runtime_error(StrUtil::PrettyError(location, "Invalid key '", pInfo[0], "' in parameter '", parameter, "'"));
+            if(fInfo[0] == "n") funcName = fInfo[1];
+            else if(fInfo[0] == "v") values.push_back(fInfo[1]);
+            else if(fInfo[0] == "ax") isY = "y" == fInfo[1];
+            else throw std::runtime_error(StrUtil::PrettyError(location, "Invalid key '", fInfo[0], "' in parameter '", parameter, "'"));
         }
 
         if(isY == readY){
-            weight.AddParticle(part, wp, reader);
+            function.alias = funcName;
+            function.values = values;
         }
     }
+
+    if(!readY and !StrUtil::Find(parameter, "c:").empty()) DecodeCut(parameter, function, location);
+
+    return function;
 }
 
-void Decoder::GetBinning(const std::string& parameter, TH1* hist, const bool& isY, const std::experimental::source_location& location){
+AnalysisPlan::Binning Decoder::DecodeBinning(const std::string& parameter, const bool& isY, const std::experimental::source_location& location){
     if(StrUtil::Find(parameter, "h:").empty()) throw std::runtime_error(StrUtil::PrettyError(location, "No function key 'h:' in '",  parameter, "'!"));
 
     std::vector<std::string> lines = StrUtil::Split(parameter, "/");
     lines.erase(std::remove_if(lines.begin(), lines.end(), [&](std::string l){return StrUtil::Find(l, "h:").empty();}), lines.end());
 
-    int xBins = 30, yBins = -1.; 
-    float xlow = 0, xhigh = 1, ylow = 0, yhigh = 1;
-    std::vector<double> xV, yV;
+    AnalysisPlan::Binning xBins, yBins;
+    yBins.nBins = -1;
 
     for(const std::string line : lines){
         std::string histLine = line.substr(line.find("h:")+2);
@@ -95,45 +82,22 @@ void Decoder::GetBinning(const std::string& parameter, TH1* hist, const bool& is
         for(std::string& histParam: StrUtil::Split(histLine, ",")){
             std::vector<std::string> hInfo = histParam != "" ? StrUtil::Split(histParam, "=") : StrUtil::Split(histLine, "=");
 
-            if(hInfo[0] == "nxb") xBins = std::stof(hInfo[1]);
-            else if(hInfo[0] == "xl") xlow = std::stof(hInfo[1]);
-            else if(hInfo[0] == "xh") xhigh = std::stof(hInfo[1]);
-            else if(hInfo[0] == "nyb") yBins = std::stof(hInfo[1]);
-            else if(hInfo[0] == "yl") ylow = std::stof(hInfo[1]);
-            else if(hInfo[0] == "yh") yhigh = std::stof(hInfo[1]);
-            else if(hInfo[0] == "xv") xV.push_back(std::stof(hInfo[1]));
-            else if(hInfo[0] == "yv") yV.push_back(std::stof(hInfo[1]));
+            if(hInfo[0] == "nxb") xBins.nBins = std::stof(hInfo[1]);
+            else if(hInfo[0] == "xl") xBins.low = std::stof(hInfo[1]);
+            else if(hInfo[0] == "xh") xBins.high = std::stof(hInfo[1]);
+            else if(hInfo[0] == "nyb") yBins.nBins = std::stof(hInfo[1]);
+            else if(hInfo[0] == "yl") yBins.low = std::stof(hInfo[1]);
+            else if(hInfo[0] == "yh") yBins.high = std::stof(hInfo[1]);
+            else if(hInfo[0] == "xv") xBins.edges.push_back(std::stof(hInfo[1]));
+            else if(hInfo[0] == "yv") yBins.edges.push_back(std::stof(hInfo[1]));
             else throw std::runtime_error(StrUtil::PrettyError(location, "Invalid key '", hInfo[0], "' in parameter '", parameter, "'"));
         }
     }
 
-    if(!isY){
-        if(xV.empty()) hist->SetBins(xBins, xlow, xhigh);
-        else hist->SetBins(xV.size() - 1, xV.data());
-    }
-    
-    else{
-       if(xV.empty() and yV.empty()) hist->SetBins(xBins, xlow, xhigh, yBins, ylow, yhigh);
-
-       else if(!xV.empty() and yV.empty()){
-            std::vector<double> yBinning = VUtil::Range<double>(ylow, yhigh, yBins + 1);
-
-            hist->SetBins(xV.size() - 1, xV.data(), yBinning.size() - 1, yBinning.data());
-       }
-
-       else if(xV.empty() and !yV.empty()){
-            std::vector<double> xBinning = VUtil::Range<double>(xlow, xhigh, xBins + 1);
-
-            hist->SetBins(xBinning.size() - 1, xBinning.data(), yV.size() - 1, yV.data());
-       }
-
-       else hist->SetBins(xV.size() - 1, xV.data(), yV.size() - 1, yV.data());
-
-hist->Print();
-    }
+    return isY ? yBins : xBins;
 }
 
-void Decoder::GetCut(const std::string& parameter, NTupleFunction& func, const std::experimental::source_location& location){
+void Decoder::DecodeCut(const std::string& parameter, AnalysisPlan::Function& function, const std::experimental::source_location& location){
     if(StrUtil::Find(parameter, "c:").empty()) throw std::runtime_error(StrUtil::PrettyError(location, "No function key 'c:' in '",  parameter, "'!"));
 
     std::string comp; std::vector<float> compValues;
@@ -152,6 +116,37 @@ void Decoder::GetCut(const std::string& parameter, NTupleFunction& func, const s
         else throw std::runtime_error(StrUtil::PrettyError(location, "Invalid key '", cInfo[0], "' in parameter '", parameter, "'"));
     }
 
-    if(compValues.size() == 1) func.AddCut(compValues.at(0), VUtil::At(compMap,comp));
-    else func.AddCut(compValues, VUtil::At(compMap,comp));
+    function.cutOp = VUtil::At(compMap, comp);
+    function.cutValues = compValues;
+}
+
+void Decoder::GetFunction(const std::string& parameter, NTupleFunction& func, const bool& readY, const std::experimental::source_location& location){
+    AnalysisPlan::Function function = DecodeFunction(parameter, readY, location);
+
+    if(function.alias != "") func.AddFunction(function.alias, function.values);
+}
+
+void Decoder::GetParticle(const std::string& parameter, NTupleFunction& func, const bool& readY, const std::experimental::source_location& location){
+    for(const AnalysisPlan::Particle& part : DecodeParticles(parameter, readY, location)){
+        func.AddParticle(part.alias, part.idx, part.wp);
+    }
+}
+
+void Decoder::GetParticle(const std::string& parameter, NTupleReader& reader, Weighter& weight, const bool& readY, const std::experimental::source_location& location){
+    for(const AnalysisPlan::Particle& part : DecodeParticles(parameter, readY, location)){
+        weight.AddParticle(part.alias, part.wp, reader);
+    }
+}
+
+void Decoder::GetBinning(const std::string& parameter, TH1* hist, const bool& isY, const std::experimental::source_location& location){
+    if(!isY) AnalysisPlan::SetBins(hist, DecodeBinning(parameter, false, location));
+    else AnalysisPlan::SetBins(hist, DecodeBinning(parameter, false, location), DecodeBinning(parameter, true, location));
+}
+
+void Decoder::GetCut(const std::string& parameter, NTupleFunction& func, const std::experimental::source_location& location){
+    AnalysisPlan::Function function;
+    DecodeCut(parameter, function, location);
+
+    if(function.cutValues.size() == 1) func.AddCut(function.cutValues.at(0), function.cutOp);
+    else func.AddCut(function.cutValues, function.cutOp);
 }
@@ -1,24 +1,46 @@
 #include <ChargedAnalysis/Analysis/include/histmaker.h>
 
 HistMaker::HistMaker(const std::vector<std::string>& parameters, const std::vector<std::string>& regions, const std::map<std::string, std::vector<std::string>>& cutStrings, const std::map<std::string, std::string>& outDir, const std::string& outFile, const std::string &channel, const std::map<std::string, std::vector<std::string>>& systDirs, const std::vector<std::string>& scaleSysts, const std::string& fakeRateFile, const std::string& promptRateFile, const int& era):
-    parameters(parameters),
-    regions(regions),
-    cutStrings(cutStrings),
+    HistMaker(AnalysisPlan(parameters, regions, cutStrings, scaleSysts), outDir, outFile, channel, systDirs, fakeRateFile, promptRateFile, era){}
+
+HistMaker::HistMaker(const AnalysisPlan& plan, const std::map<std::string, std::string>& outDir, const std::string& outFile, const std::string &channel, const std::map<std::string, std::vector<std::string>>& systDirs, const std::string& fakeRateFile, const std::string& promptRateFile, const int& era):
+    plan(plan),
+    regions(plan.regions),
+    scaleSysts(plan.scaleSysts),
     outDir(outDir),
     outFile(outFile),
     channel(channel),
     systDirs(systDirs),
-    scaleSysts(scaleSysts),
     fakeRateFile(fakeRateFile),
     promptRateFile(promptRateFile),
     era(era){}
 
 void HistMaker::PrepareHists(const std::shared_ptr<TFile>& inFile, const std::shared_ptr<TTree> inTree, NTupleReader& reader, const std::experimental::source_location& location){
-    Decoder parser;
     bool isData = !RUtil::BranchExists(inTree.get(), "Electron_GenID");
 
+    //Each parameter is only compiled once and shared by all regions and systematics
+    std::vector<std::pair<NTupleFunction, NTupleFunction>> paramFunctions;
+
+    for(const AnalysisPlan::Parameter& parameter: plan.parameters){
+        //Read in everything, orders matter
+        if(parameter.x.getSF){
+            Weighter w(inFile, inTree, era);
+            AnalysisPlan::AddWeights(parameter.x, reader, w);
+            histPartWeight[hist1DFunctions.size()] = w;
+        }
+
+        NTupleFunction paramX = AnalysisPlan::Build(parameter.x, reader);
+        NTupleFunction paramY = parameter.hasY ? AnalysisPlan::Build(parameter.y, reader) : reader.BuildFunc();
+
+        if(!parameter.hasY) hist1DFunctions.push_back(paramX);
+        else hist2DFunctions.push_back({paramX, paramY});
+
+        paramFunctions.push_back({paramX, paramY});
+    }
+
     for(unsigned int i = 0; i < regions.size(); ++i){
         std::string region = regions[i];
+        selector.AddRegion();
 
         for(const std::string& scaleSyst : VUtil::Merge(std::vector<std::string>{"Nominal"}, scaleSysts)){
             for(const std::string shift : {"Up", "Down"}){
@@ -27,75 +49,69 @@ void HistMaker::PrepareHists(const std::shared_ptr<TFile>& inFile, const std::sh
 
                 std::string systName = scaleSyst != "Nominal" ? StrUtil::Merge(scaleSyst, shift) : "Nominal";
                 std::string outName, outNameForMisIDJ;
+                TDirectory* outDirectory = nullptr, *outDirectoryMisIDJ = nullptr;
+
+                //Change outdir for systematic, histograms of workers are kept in memory and added to the main histograms
+                if(!isWorker){
+                    if(scaleSyst == "Nominal"){
+                        outName = StrUtil::Join("/", outDir[region], outFile);
+                        std::system(StrUtil::Merge("mkdir -p ", outDir[region]).c_str());
+
+                        if(isMisIDJ){
+                            std::string procToReplace = !StrUtil::Find(channel, "Muon").empty() ? "SingleMu" : "SingleE";
+                            outNameForMisIDJ = StrUtil::Replace(StrUtil::Join("/", outDir[region], outFile), procToReplace, "MisIDJ", "MisIDJ");
+                            std::system(StrUtil::Merge("mkdir -p ", StrUtil::Replace(outDir[region], procToReplace, "MisIDJ")).c_str());
+                        }
+                    }
+                    else{
+                        for(const std::string dir : systDirs[region]){
+                            std::system(StrUtil::Merge("mkdir -p ", dir).c_str());
+                            if(!StrUtil::Find(dir, systName).empty()) outName = StrUtil::Join("/", dir, outFile);
+                        }
+                    }
 
-                //Change outdir for systematic
-                if(scaleSyst == "Nominal"){
-                    outName = StrUtil::Join("/", outDir[region], outFile);
-                    std::system(StrUtil::Merge("mkdir -p ", outDir[region]).c_str());
+                    outFiles.push_back(std::make_shared<TFile>(outName.c_str(), "RECREATE"));
+                    outDirectory = outFiles.back().get();
 
                     if(isMisIDJ){
-                        std::string procToReplace = !StrUtil::Find(channel, "Muon").empty() ? "SingleMu" : "SingleE";
-                        outNameForMisIDJ = StrUtil::Replace(StrUtil::Join("/", outDir[region], outFile), procToReplace, "MisIDJ", "MisIDJ");
-                        std::system(StrUtil::Merge("mkdir -p ", StrUtil::Replace(outDir[region], procToReplace, "MisIDJ")).c_str());
-                    }
-                }
-                else{
-                    for(const std::string dir : systDirs[region]){
-                        std::system(StrUtil::Merge("mkdir -p ", dir).c_str());
-                        if(!StrUtil::Find(dir, systName).empty()) outName = StrUtil::Join("/", dir, outFile);
+                        outFilesForMisIDJ.push_back(std::make_shared<TFile>(outNameForMisIDJ.c_str(), "RECREATE"));
+                        outDirectoryMisIDJ = outFilesForMisIDJ.back().get();
                     }
                 }
 
-                outFiles.push_back(std::make_shared<TFile>(outName.c_str(), "RECREATE"));
-                if(isMisIDJ) outFilesForMisIDJ.push_back(std::make_shared<TFile>(outNameForMisIDJ.c_str(), "RECREATE"));
-
                 //Histograms for event count
                 if(scaleSyst == "Nominal"){
                     eventCount.push_back(std::make_shared<TH1F>("EventCount", "EventCount", 1, 0, 1));
-                    eventCount.back()->SetDirectory(outFiles.back().get());
+                    eventCount.back()->SetDirectory(outDirectory);
 
                     if(isMisIDJ){
                         eventCountMisIDJ.push_back(std::make_shared<TH1F>("EventCount", "EventCount", 1, 0, 1));
-                        eventCountMisIDJ.back()->SetDirectory(outFilesForMisIDJ.back().get());
+                        eventCountMisIDJ.back()->SetDirectory(outDirectoryMisIDJ);
                     }
                 }
 
                 else{
                     if(shift == "Up"){
                         eventCountSystUp.push_back(std::make_shared<TH1F>("EventCount", "EventCount", 1, 0, 1));
-                        eventCountSystUp.back()->SetDirectory(outFiles.back().get());
+                        eventCountSystUp.back()->SetDirectory(outDirectory);
                     }
 
                     if(shift == "Down"){
                         eventCountSystDown.push_back(std::make_shared<TH1F>("EventCount", "EventCount", 1, 0, 1));
-                        eventCountSystDown.back()->SetDirectory(outFiles.back().get());
+                        eventCountSystDown.back()->SetDirectory(outDirectory);
                     }
                 }
 
                 //Histograms for other parameters
-                for(const std::string& parameter: parameters){
-                    if(StrUtil::Find(parameter, "h:").empty()) throw std::runtime_error(StrUtil::PrettyError(location, "Missing key 'h:' in parameter '", parameter, "'!"));
-
-                    //Functor structure and arguments
-                    NTupleFunction paramX = reader.BuildFunc(), paramY = reader.BuildFunc();
-            
-                    //Read in everything, orders matter
-                    if(!StrUtil::Find(parameter, "getSF").empty() and scaleSyst == "Nominal" and i == 0){
-                        Weighter w(inFile, inTree, era);
-                        parser.GetParticle(parameter, reader, w);
-                        histPartWeight[hist1DFunctions.size()] = w;
-                    }
+                for(unsigned int j = 0; j < plan.parameters.size(); ++j){
+                    const AnalysisPlan::Parameter& parameter = plan.parameters[j];
+                    NTupleFunction& paramX = paramFunctions[j].first, &paramY = paramFunctions[j].second;
 
-                    parser.GetParticle(parameter, paramX);
-                    parser.GetFunction(parameter, paramX);
-
-                    paramX.Compile();
-
-                    if(!parser.hasYInfo(parameter)){
+                    if(!parameter.hasY){
                         std::shared_ptr<TH1F> hist1D = std::make_shared<TH1F>();
-                        parser.GetBinning(parameter, hist1D.get());
+                        AnalysisPlan::SetBins(hist1D.get(), parameter.xBins);
 
-                        hist1D->SetDirectory(outFiles.back().get());
+                        hist1D->SetDirectory(outDirectory);
                         hist1D->SetName(paramX.GetHistName().c_str());       
                         hist1D->SetTitle(paramX.GetHistName().c_str());
                         hist1D->GetXaxis()->SetTitle(paramX.GetAxisLabel().c_str());
@@ -113,20 +129,13 @@ void HistMaker::PrepareHists(const std::shared_ptr<TFile>& inFile, const std::sh
                                 hists1DSystDown.push_back(std::move(hist1D));
                             }
                         }
-
-                        if(scaleSyst == "Nominal" and i == 0) hist1DFunctions.push_back(paramX);
                     }
 
                     else{
-                        parser.GetParticle(parameter, paramY, true);
-                        parser.GetFunction(parameter, paramY, true);
-
-                        paramY.Compile();
-
                         std::shared_ptr<TH2F> hist2D = std::make_shared<TH2F>();
-                        parser.GetBinning(parameter, hist2D.get(), true);
+                        AnalysisPlan::SetBins(hist2D.get(), parameter.xBins, parameter.yBins);
 
-                        hist2D->SetDirectory(outFiles.back().get());
+                        hist2D->SetDirectory(outDirectory);
                         hist2D->SetName((paramX.GetHistName() + "_VS_" + paramY.GetHistName()).c_str());       
                         hist2D->SetTitle((paramX.GetHistName() + "_VS_" + paramY.GetHistName()).c_str());
 
@@ -145,26 +154,21 @@ void HistMaker::PrepareHists(const std::shared_ptr<TFile>& inFile, const std::sh
                                 hists2DSystDown.push_back(std::move(hist2D));
                             }
                         }
-
-                        if(scaleSyst == "Nominal" and i == 0) hist2DFunctions.push_back({paramX, paramY});
                     }
                 }
             }
         }
 
-        std::cout << std::endl << "Cuts for region '" << region << "'" << std::endl;
+        if(!isWorker) std::cout << std::endl << "Cuts for region '" << region << "'" << std::endl;
 
         int nCuts = 0;
 
-        for(const std::string& cutString: cutStrings[region]){
-            //Functor structure and arguments
+        for(const AnalysisPlan::Function& cutInfo: plan.cuts.at(region)){
+            //Functor structure and arguments, cuts shared by regions are only compiled once by the reader
             NTupleFunction cut = reader.BuildFunc();
             
             try{
-                parser.GetParticle(cutString, cut);
-                parser.GetFunction(cutString, cut);
-                parser.GetCut(cutString, cut);
-                cut.Compile();
+                cut = AnalysisPlan::Build(cutInfo, reader);
             }
 
             catch(const std::exception& e){
@@ -172,46 +176,131 @@ void HistMaker::PrepareHists(const std::shared_ptr<TFile>& inFile, const std::sh
                 else throw std::runtime_error(e.what());
             }
 
-            if(!StrUtil::Find(cutString, "getSF").empty()){
+            if(cutInfo.getSF){
                 Weighter w(inFile, inTree, era);
-                parser.GetParticle(cutString, reader, w);
+                AnalysisPlan::AddWeights(cutInfo, reader, w);
                 cutPartWeight[cutFunctions.size()] = std::move(w);
             }
 
-            std::cout << "Cut will be applied: '" << cut.GetCutName() << "'" << std::endl;
+            if(!isWorker) std::cout << "Cut will be applied: '" << cut.GetCutName() << "'" << std::endl;
 
+            selector.AddCut(i, cut);
             cutFunctions.push_back(std::move(cut));
             ++nCuts;
         }
 
         cutIdxRange.push_back(nCuts + (cutIdxRange.size() == 0 ? 0 : cutIdxRange.back()));
     }
+
+    CompileFillPlan();
+}
+
+void HistMaker::CompileFillPlan(){
+    std::function<std::size_t(TH1*)> accumulate = [&](TH1* hist){
+        accumulators.push_back(HistAccumulator(hist));
+        accumulatedHists.push_back(hist);
+
+        return accumulators.size() - 1;
+    };
+
+    for(unsigned int j = 0; j < hist1DFunctions.size(); ++j){
+        histWeights.push_back(histPartWeight.count(j) ? &histPartWeight.at(j) : nullptr);
+        axes1D.push_back(HistAxis(hists1D.at(j)->GetXaxis()));
+    }
+
+    for(unsigned int j = 0; j < hist2DFunctions.size(); ++j){
+        axes2D.push_back({HistAxis(hists2D.at(j)->GetXaxis()), HistAxis(hists2D.at(j)->GetYaxis())});
+    }
+
+    for(unsigned int syst = 0; syst <= scaleSysts.size(); ++syst){
+        std::string systName = syst == 0 ? "Nominal" : scaleSysts[syst - 1];
+
+        for(const std::string& shift : {"Up", "Down"}){
+            if(syst == 0 and shift == "Down") continue;
+
+            for(unsigned int region = 0; region < regions.size(); ++region){
+                WeightSlot slot{region, false, systName == "PileUp" ? shift : ""};
+
+                for(unsigned int j = region == 0 ? 0 : cutIdxRange[region-1]; j < cutIdxRange[region]; ++j){
+                    if(cutPartWeight.count(j)) slot.cutWeights.push_back({&cutPartWeight.at(j), cutPartWeight.at(j).GetWeightIndex(systName, shift)});
+                }
+
+                weightSlots.push_back(slot);
+                std::size_t w = weightSlots.size() - 1, systIdx = (syst - 1) + scaleSysts.size()*region;
+
+                if(syst == 0) countPlan.push_back({0, w, false, accumulate(eventCount[region].get())});
+                else countPlan.push_back({0, w, false, accumulate((shift == "Up" ? eventCountSystUp : eventCountSystDown)[systIdx].get())});
+
+                for(unsigned int j = 0; j < hist1DFunctions.size(); ++j){
+                    if(syst == 0) fill1DPlan.push_back({j, w, true, accumulate(hists1D.at(j + hist1DFunctions.size()*region).get())});
+                    else fill1DPlan.push_back({j, w, true, accumulate((shift == "Up" ? hists1DSystUp : hists1DSystDown).at(j + hist1DFunctions.size()*systIdx).get())});
+                }
+
+                for(unsigned int j = 0; j < hist2DFunctions.size(); ++j){
+                    if(syst == 0) fill2DPlan.push_back({j, w, false, accumulate(hists2D.at(j + hist2DFunctions.size()*region).get())});
+                    else fill2DPlan.push_back({j, w, false, accumulate((shift == "Up" ? hists2DSystUp : hists2DSystDown).at(j + hist2DFunctions.size()*systIdx).get())});
+                }
+
+                //Nominal histograms for the QCD estimation only get the fake rate weight
+                if(syst != 0 or !isMisIDJ) continue;
+
+                weightSlots.push_back({region, true});
+                w = weightSlots.size() - 1;
+
+                countPlan.push_back({0, w, false, accumulate(eventCountMisIDJ[region].get())});
+
+                for(unsigned int j = 0; j < hist1DFunctions.size(); ++j){
+                    fill1DPlan.push_back({j, w, false, accumulate(hists1DMisIDJ.at(j + hist1DFunctions.size()*region).get())});
+                }
+
+                for(unsigned int j = 0; j < hist2DFunctions.size(); ++j){
+                    fill2DPlan.push_back({j, w, false, accumulate(hists2DMisIDJ.at(j + hist2DFunctions.size()*region).get())});
+                }
+            }
+        }
+    }
+}
+
+void HistMaker::SetEntryLists(const std::map<std::string, std::string>& entryListFiles, const std::experimental::source_location& location){
+    entryLists.clear();
+
+    for(const std::string& region : regions){
+        if(!entryListFiles.count(region) or entryListFiles.at(region) == ""){
+            throw std::runtime_error(StrUtil::PrettyError(location, "Entry list for region '", region, "' is missing, either all or no regions need an entry list!"));
+        }
+
+        if(EntryIndex::IsIndex(entryListFiles.at(region))) entryLists.push_back(EntryIndex(entryListFiles.at(region)).GetEntries());
+
+        else{
+            CSV entryList(entryListFiles.at(region), "r", "\t");
+            entryLists.push_back(entryList.GetColumn<long long>(0));
+        }
+
+        std::sort(entryLists.back().begin(), entryLists.back().end());
+    }
 }
 
-void HistMaker::Produce(const std::string& fileName, const int& eventStart, const int& eventEnd, const std::string& bkgYieldFac, const std::string& bkgType, const std::vector<std::string>& bkgYieldFacSyst){
+void HistMaker::Book(const std::string& fileName, const std::string& bkgYieldFac, const std::string& bkgType, const std::vector<std::string>& bkgYieldFacSyst){
     //Get input tree
     inputFile = RUtil::Open(fileName);
     inputTree = RUtil::GetSmart<TTree>(inputFile.get(), channel);
-    NTupleReader reader(inputTree, era);
+    reader = std::make_shared<NTupleReader>(inputTree, era);
     
     baseWeight = Weighter(inputFile, inputTree, era);
 
-    std::cout << "Read file: '" << fileName << "'" << std::endl;
-    std::cout << "Read tree '" << channel << "'" << std::endl;
-    std::cout << "----------------------------------" << std::endl;
-
-    gROOT->SetBatch(kTRUE);
-    TH1::SetDefaultSumw2();
+    if(!isWorker){
+        std::cout << "Read file: '" << fileName << "'" << std::endl;
+        std::cout << "Read tree '" << channel << "'" << std::endl;
+        std::cout << "----------------------------------" << std::endl;
+    }
 
     //Open output file and set up all histograms/tree and their function to call
     isMisIDJ = promptRateFile != "";
-    PrepareHists(inputFile, inputTree, reader);
+    PrepareHists(inputFile, inputTree, *reader);
 
-    std::cout << "----------------------------------" << std::endl; 
+    if(!isWorker) std::cout << "----------------------------------" << std::endl; 
 
     //Data driven scale factors
-    float bkgY = 1.;
-    std::vector<float> bkgYUp, bkgYDown;
 
     if(!bkgYieldFac.empty()){
         for(unsigned int syst = 0; syst <= scaleSysts.size(); ++syst){
@@ -243,30 +332,26 @@ void HistMaker::Produce(const std::string& fileName, const int& eventStart, cons
     }
 
     //Prepare QCD estimatation if wished
-    std::shared_ptr<TFile> fFile, pFile;
-    std::shared_ptr<TH2F> promptRate, fakeRate;
-    NTupleFunction lPt = reader.BuildFunc(), lEta = reader.BuildFunc();
-    float fRate, pRate, wLoose = 1., wTight = 1.;
-    std::function<float(float&, float&)> f1 = [&](float& f, float& p){return (f*p)/(p-f);};
-
-    std::function<float(float&)> f2 = [&](float& p){return (1.-p)/p;};
-
     if(fakeRateFile != ""){
-        fFile = RUtil::Open(fakeRateFile);
-        pFile = RUtil::Open(promptRateFile);
+        std::shared_ptr<TFile> fFile = RUtil::Open(fakeRateFile);
+        std::shared_ptr<TFile> pFile = RUtil::Open(promptRateFile);
 
-        fakeRate = RUtil::CloneSmart(RUtil::Get<TH2F>(fFile.get(), "fakerate"));
-        promptRate = RUtil::CloneSmart(RUtil::Get<TH2F>(pFile.get(), "promptrate"));
+        //Empty bins, e.g. for pt out of range, take the rate of the last pt bin
+        fakeRate = RateTable(RUtil::Get<TH2F>(fFile.get(), "fakerate"));
+        fakeRate.FillEmpty(79.9);
 
-        Decoder parser;
+        promptRate = RateTable(RUtil::Get<TH2F>(pFile.get(), "promptrate"));
+        promptRate.FillEmpty(199.9);
 
-        lPt.AddParticle(!StrUtil::Find(channel, "Ele").empty() ? "e" : "mu", 1, "loose");
-        lPt.AddFunction("pt");
-        lPt.Compile();
+        lPt = std::make_shared<NTupleFunction>(reader->BuildFunc());
+        lPt->AddParticle(!StrUtil::Find(channel, "Ele").empty() ? "e" : "mu", 1, "loose");
+        lPt->AddFunction("pt");
+        lPt->Compile();
 
-        lEta.AddParticle(!StrUtil::Find(channel, "Ele").empty() ? "e" : "mu", 1, "loose");
-        lEta.AddFunction("eta");
-        lEta.Compile();
+        lEta = std::make_shared<NTupleFunction>(reader->BuildFunc());
+        lEta->AddParticle(!StrUtil::Find(channel, "Ele").empty() ? "e" : "mu", 1, "loose");
+        lEta->AddFunction("eta");
+        lEta->Compile();
     }
     
     //Cutflow/Event count histogram
@@ -276,134 +361,186 @@ void HistMaker::Produce(const std::string& fileName, const int& eventStart, cons
         cutflows.push_back(RUtil::CloneSmart(RUtil::Get<TH1F>(inputFile.get(), "Cutflow_" + channel)));
         cutflows.back()->SetName("cutflow"); cutflows.back()->SetTitle("cutflow");
     }
+}
 
-    StopWatch timer; 
-    timer.Start();
-    timer.SetTimeMark();
-    int nTimeMarks = 0;
+void HistMaker::Loop(const int& eventStart, const int& eventEnd){
+    //Only read branches needed by functions and weights
+    std::vector<std::string> weightBranches = baseWeight.GetBranchNames();
 
-    std::vector<bool> passed(regions.size(), true);
-    bool allFailed = false;
-    double wght = 1., wghtMisIDJ = 1.;;
+    for(std::pair<const int, Weighter>& w : cutPartWeight) weightBranches = VUtil::Merge(weightBranches, w.second.GetBranchNames());
+    for(std::pair<const int, Weighter>& w : histPartWeight) weightBranches = VUtil::Merge(weightBranches, w.second.GetBranchNames());
 
-    std::vector<float> values1D(hist1DFunctions.size(), 1.);
-    std::vector<std::pair<float, float>> values2D(hist2DFunctions.size(), {1., 1.});
+    //Union of the entry lists in this range with the bitmask of regions listing the entry
+    std::vector<std::pair<long long, std::uint64_t>> listedEntries;
 
-    std::cout << std::endl << "Start processing tree at event '" << eventStart << "'" << std::endl;
+    if(!entryLists.empty()){
+        for(unsigned int region = 0; region < regions.size(); ++region){
+            std::vector<long long>::const_iterator it = std::lower_bound(entryLists[region].begin(), entryLists[region].end(), eventStart);
 
-    for (int entry = eventStart; entry < eventEnd; ++entry){
-        if(entry % 10000 == 0 and entry != eventStart){
-            std::cout << "Processed events: " << entry-eventStart << " (" << 10000./(timer.SetTimeMark() - timer.GetTimeMark(nTimeMarks)) << " eve/s)" << std::endl;
-            ++nTimeMarks;
+            for(; it != entryLists[region].end() and *it < eventEnd; ++it) listedEntries.push_back({*it, std::uint64_t(1) << region});
         }
 
-        //Set entry
-        reader.SetEntry(entry);
+        std::sort(listedEntries.begin(), listedEntries.end());
 
-        //Check if event passed all cuts
-        allFailed = true;
+        std::vector<std::pair<long long, std::uint64_t>> merged;
 
-        for(unsigned int region = 0; region < regions.size(); ++region){
-            passed[region] = true;
+        for(const std::pair<long long, std::uint64_t>& entry : listedEntries){
+            if(!merged.empty() and merged.back().first == entry.first) merged.back().second |= entry.second;
+            else merged.push_back(entry);
+        }
 
-            for(unsigned int j = region == 0 ? 0 : cutIdxRange[region-1]; j < cutIdxRange[region]; ++j){
-                passed[region] = passed[region] and cutFunctions.at(j).GetPassed();
-                if(!passed[region]) break;
-            }
+        listedEntries = std::move(merged);
+        reader->SetEntryList(VUtil::Transform<long long>(listedEntries, [](const std::pair<long long, std::uint64_t>& entry){return entry.first;}));
+    }
 
-            allFailed = allFailed and !passed[region];
-        }
+    reader->SetupCache(eventStart, eventEnd, weightBranches);
+    
+    StopWatch timer; 
+    timer.Start();
+    timer.SetTimeMark();
+    int nTimeMarks = 0;
 
-        if(allFailed) continue;
+    float fRate, pRate, wLoose = 1., wTight = 1.;
+    std::function<float(float&, float&)> f1 = [&](float& f, float& p){return (f*p)/(p-f);};
 
-        if(fakeRate){
-            float lpt = lPt.Get();
-            float leta = lEta.Get();
+    std::function<float(float&)> f2 = [&](float& p){return (1.-p)/p;};
+
+    std::vector<bool> passed(regions.size(), true), slotPassed(weightSlots.size(), false);
+    std::vector<double> weights(weightSlots.size(), 1.), partWeights(histWeights.size(), 1.);
+
+    std::vector<float> values1D(hist1DFunctions.size(), 1.);
+    std::vector<std::pair<float, float>> values2D(hist2DFunctions.size(), {1., 1.});
+    std::vector<int> bins1D(hist1DFunctions.size(), 0), bins2D(hist2DFunctions.size(), 0);
 
-            fRate = fakeRate->GetBinContent(fakeRate->FindBin(lpt, leta));
-            pRate = promptRate->GetBinContent(promptRate->FindBin(lpt, leta));
+    std::function<void(const int&)> fill = [&](const int& entry){
+        //Set entry
+        reader->SetEntry(entry);
+
+        if(fakeRate){
+            float lpt = lPt->Get();
+            float leta = lEta->Get();
 
-            if(fRate == 0) fRate = fakeRate->GetBinContent(fakeRate->FindBin(79.9, leta));
-            if(pRate == 0) pRate = promptRate->GetBinContent(promptRate->FindBin(199.9, leta));
+            fRate = fakeRate.Get(lpt, leta);
+            pRate = promptRate.Get(lpt, leta);
 
             wLoose = f1(fRate, pRate);
             wTight = wLoose * f2(pRate);
         }
         
-        //Fill histograms
+        //Evaluate functions once for all regions and systematics
         for(unsigned int j=0; j < hist1DFunctions.size(); ++j){
             values1D[j] = hist1DFunctions.at(j).Get();
+            bins1D[j] = axes1D[j].FindBin(values1D[j]);
         }
 
         for(unsigned int j=0; j < hist2DFunctions.size(); ++j){
             values2D[j] = {hist2DFunctions[j].first.Get(), hist2DFunctions[j].second.Get()};
+            bins2D[j] = HistAccumulator::GetBin(axes2D[j].first, axes2D[j].first.FindBin(values2D[j].first), axes2D[j].second.FindBin(values2D[j].second));
         }
 
-        for(unsigned int syst = 0; syst <= scaleSysts.size(); ++syst){
-            std::string systName = syst == 0 ? "Nominal" : scaleSysts[syst - 1];
+        //Weights for each (syst, shift, region) slot and particle weights of each histogram
+        for(unsigned int w = 0; w < weightSlots.size(); ++w){
+            const WeightSlot& slot = weightSlots[w];
 
-            for(const std::string& shift : {"Up", "Down"}){
-                if(syst == 0 and shift == "Down") continue;
+            slotPassed[w] = passed[slot.region];
+            if(!slotPassed[w]) continue;
 
-                for(unsigned int region = 0; region < regions.size(); ++region){
-                    if(!passed[region]) continue;
-                    wght = baseWeight.GetBaseWeight(entry, systName == "PileUp" ? shift : "") * bkgY;
-                    wghtMisIDJ = (isMisIDJ and region % 2 == 0 ? wTight : wLoose);
+            if(slot.isMisIDJ){
+                weights[w] = slot.region % 2 == 0 ? wTight : wLoose;
+                continue;
+            }
 
-                    for(unsigned int j = region == 0 ? 0 : cutIdxRange[region-1]; j < cutIdxRange[region]; ++j){
-                        wght *= cutPartWeight.count(j) ? cutPartWeight.at(j).GetPartWeight(entry, systName, shift) : 1.;
-                    }
+            weights[w] = baseWeight.GetBaseWeight(entry, slot.baseShift) * bkgY;
 
-                    if(syst == 0){
-                        eventCount[region]->Fill(0., wght);
-                        if(isMisIDJ) eventCountMisIDJ[region]->Fill(0., wghtMisIDJ);
-                    }
+            for(const std::pair<Weighter*, std::size_t>& cutWeight : slot.cutWeights){
+                weights[w] *= cutWeight.first->GetPartWeights(entry)[cutWeight.second];
+            }
+        }
 
-                    else{
-                        if(shift == "Up") eventCountSystUp[(syst - 1) + region*(scaleSysts.size())]->Fill(0., wght);
-                        else eventCountSystDown[(syst - 1) + region*(scaleSysts.size())]->Fill(0., wght);
-                    }
+        for(unsigned int j = 0; j < histWeights.size(); ++j){
+            partWeights[j] = histWeights[j] != nullptr ? histWeights[j]->GetPartWeights(entry)[0] : 1.;
+        }
 
-                    for(unsigned int j=0; j < hist1DFunctions.size(); ++j){
-                        if(!passed[region]) continue;
+        //Fill histograms
+        for(const FillTarget& target : countPlan){
+            if(slotPassed[target.weight]) accumulators[target.accumulator].Fill(1, weights[target.weight]);
+        }
 
-                        unsigned int index = j + hist1DFunctions.size()*region;
-                        unsigned int systIndex = j + hist1DFunctions.size()*((syst - 1) + scaleSysts.size()*region);
+        for(const FillTarget& target : fill1DPlan){
+            if(slotPassed[target.weight]) accumulators[target.accumulator].Fill(bins1D[target.value], weights[target.weight] * (target.partWeight ? partWeights[target.value] : 1.));
+        }
 
-                        float pW = histPartWeight.count(j) ? histPartWeight[j].GetPartWeight(entry) : 1.;
-        
-                        if(syst == 0){
-                            hists1D.at(index)->Fill(values1D[j], wght*pW);
-                            if(isMisIDJ) hists1DMisIDJ.at(index)->Fill(values1D[j], wghtMisIDJ);
-                        }
+        for(const FillTarget& target : fill2DPlan){
+            if(slotPassed[target.weight]) accumulators[target.accumulator].Fill(bins2D[target.value], weights[target.weight]);
+        }
+    };
 
-                        else{
-                            if(shift == "Up") hists1DSystUp.at(systIndex)->Fill(values1D[j], wght*pW);
-                            else hists1DSystDown.at(systIndex)->Fill(values1D[j], wght*pW);
-                        }   
-                    }
+    if(!isWorker) std::cout << std::endl << "Start processing tree at event '" << eventStart << "'" << std::endl;
 
-                    for(unsigned int j=0; j < hist2DFunctions.size(); ++j){
-                        if(!passed[region]) continue;
+    //Sparse loop only over listed entries, the regions of each entry are already known
+    if(!entryLists.empty()){
+        for(const std::pair<long long, std::uint64_t>& entry : listedEntries){
+            for(unsigned int region = 0; region < regions.size(); ++region){
+                passed[region] = entry.second >> region & 1;
+            }
 
-                        unsigned int index = j + region*hist2DFunctions.size();
-                        unsigned int systIndex = j + hist1DFunctions.size()*(region + regions.size()*syst);
+            fill(entry.first);
+        }
 
-                        if(syst == 0){
-                            hists2D.at(index)->Fill(values2D[j].first, values2D[j].second, wght);
-                            if(isMisIDJ) hists2DMisIDJ.at(index)->Fill(values2D[j].first, values2D[j].second, wghtMisIDJ);
-                        }
+        if(!isWorker) std::cout << "Processed " << listedEntries.size() << " listed events of " << eventEnd - eventStart << " events in " << timer.GetTime() << " s" << std::endl;
+    }
 
-                        else{
-                            if(shift == "Up") hists2DSystUp.at(systIndex)->Fill(values2D[j].first, values2D[j].second, wght);
-                            else hists2DSystDown.at(systIndex)->Fill(values2D[j].first, values2D[j].second, wght);
-                        }   
-                    }
-                }
+    else{
+        for (int entry = eventStart; entry < eventEnd; ++entry){
+            if(entry % 10000 == 0 and entry != eventStart and !isWorker){
+                std::cout << "Processed events: " << entry-eventStart << " (" << 10000./(timer.SetTimeMark() - timer.GetTimeMark(nTimeMarks)) << " eve/s)" << std::endl;
+                ++nTimeMarks;
             }
+
+            //Set entry
+            reader->SetEntry(entry);
+
+            //Check if event passed all cuts of any region
+            selector.Evaluate();
+            if(!selector.AnyPassed()) continue;
+
+            for(unsigned int region = 0; region < regions.size(); ++region){
+                passed[region] = selector.Passed(region);
+            }
+
+            fill(entry);
         }
     }
 
+    if(!isWorker and entryLists.empty()) selector.Report();
+
+    for(unsigned int i = 0; i < accumulators.size(); ++i){
+        accumulators[i].Flush(accumulatedHists[i]);
+    }
+}
+
+void HistMaker::Add(const HistMaker& worker){
+    auto add = [](auto& hists, const auto& workerHists){
+        for(unsigned int i = 0; i < hists.size(); ++i) hists[i]->Add(workerHists[i].get());
+    };
+
+    add(eventCount, worker.eventCount);
+    add(eventCountMisIDJ, worker.eventCountMisIDJ);
+    add(eventCountSystUp, worker.eventCountSystUp);
+    add(eventCountSystDown, worker.eventCountSystDown);
+
+    add(hists1D, worker.hists1D);
+    add(hists1DMisIDJ, worker.hists1DMisIDJ);
+    add(hists1DSystUp, worker.hists1DSystUp);
+    add(hists1DSystDown, worker.hists1DSystDown);
+
+    add(hists2D, worker.hists2D);
+    add(hists2DMisIDJ, worker.hists2DMisIDJ);
+    add(hists2DSystUp, worker.hists2DSystUp);
+    add(hists2DSystDown, worker.hists2DSystDown);
+}
+
+void HistMaker::Write(){
     std::cout << "----------------------------------" << std::endl;
 
     for(unsigned int region = 0; region < regions.size(); ++region){
@@ -489,6 +626,62 @@ void HistMaker::Produce(const std::string& fileName, const int& eventStart, cons
             }
         }
     }
+}
+
+void HistMaker::Produce(const std::string& fileName, const int& eventStart, const int& eventEnd, const std::string& bkgYieldFac, const std::string& bkgType, const std::vector<std::string>& bkgYieldFacSyst, const int& nThreads){
+    StopWatch timer; 
+    timer.Start();
+
+    gROOT->SetBatch(kTRUE);
+    TH1::SetDefaultSumw2();
+
+    //Split event range along the tree clusters, so no basket is read by two threads
+    std::vector<std::pair<long long, long long>> ranges = {{eventStart, eventEnd}};
+
+    if(nThreads > 1){
+        ROOT::EnableThreadSafety();
+
+        std::shared_ptr<TFile> file = RUtil::Open(fileName);
+        ranges = RUtil::SplitByCluster(RUtil::Get<TTree>(file.get(), channel), eventStart, eventEnd, nThreads);
+
+        std::cout << "Process events with " << ranges.size() << " threads" << std::endl;
+    }
+
+    //This instance processes the first range, each other range is processed by a worker with own input file and reader
+    std::vector<HistMaker> workers(ranges.size() - 1, *this);
+    std::vector<HistMaker*> makers = {this};
+    std::vector<std::exception_ptr> errors(ranges.size());
+
+    for(HistMaker& worker : workers){
+        worker.isWorker = true;
+        makers.push_back(&worker);
+    }
+
+    std::function<void(const int&)> process = [&](const int& i){
+        try{
+            makers[i]->Book(fileName, bkgYieldFac, bkgType, bkgYieldFacSyst);
+            makers[i]->Loop(ranges[i].first, ranges[i].second);
+        }
+
+        catch(...){
+            errors[i] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(unsigned int i = 1; i < ranges.size(); ++i) threads.push_back(std::thread(process, i));
+
+    process(0);
+
+    for(std::thread& thread : threads) thread.join();
+    for(std::exception_ptr& error : errors){
+        if(error) std::rethrow_exception(error);
+    }
+
+    //Merge in fixed order to have reproducible output
+    for(HistMaker& worker : workers) Add(worker);
+
+    Write();
 
     std::cout << std::endl << "Time passed for complete processing: " << timer.GetTime() << " s" << std::endl;
 }
@@ -0,0 +1,36 @@
+#include <ChargedAnalysis/Analysis/include/ntupleconfig.h>
+
+NTupleConfig::NTupleConfig(){
+    pt::json_parser::read_json(StrUtil::Merge(std::getenv("CHDIR"), "/ChargedAnalysis/Analysis/data/particle.json"), partInfo);
+    pt::json_parser::read_json(StrUtil::Merge(std::getenv("CHDIR"), "/ChargedAnalysis/Analysis/data/function.json"), funcInfo);
+
+    IndexAliases(partInfo, partNames);
+    IndexAliases(funcInfo, funcNames);
+}
+
+void NTupleConfig::IndexAliases(const pt::ptree& node, std::unordered_map<std::string, std::string>& names){
+    //First child with alias wins, as in the former linear search
+    for(const std::pair<const std::string, pt::ptree>& child : node){
+        boost::optional<std::string> alias = child.second.get_optional<std::string>("alias");
+        if(alias) names.emplace(*alias, child.first);
+    }
+}
+
+const NTupleConfig& NTupleConfig::Get(){
+    //Initialization of function local static is thread safe
+    static const NTupleConfig config;
+
+    return config;
+}
+
+std::string NTupleConfig::GetPartName(const std::string& alias) const {
+    std::unordered_map<std::string, std::string>::const_iterator it = partNames.find(alias);
+
+    return it != partNames.end() ? it->second : "";
+}
+
+std::string NTupleConfig::GetFuncName(const std::string& alias) const {
+    std::unordered_map<std::string, std::string>::const_iterator it = funcNames.find(alias);
+
+    return it != funcNames.end() ? it->second : "";
+}
@@ -45,186 +45,181 @@ Cut NTupleReader::CreateCut(const std::string& op, const std::vector<float>& com
     else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Unknown cut operator: '", op, "'!"));
 }
 
-Func NTupleReader::CreateFunc(const std::string& branchName, const pt::ptree& part){
-    std::string bName = branchName;
-
+Func NTupleReader::CreateFunc(const std::string& branchName, const PartInfo* part){
     //Dummy particle, branch without particle (like eventNumber)
-    if(part.empty()){
-        TLeaf* leaf = RUtil::Get<TLeaf>(inputTree, bName);
-        return [=](const int& entry, const int& idx){return RUtil::GetEntry<float>(leaf, entry, 0);};
+    if(part == nullptr){
+        std::size_t leaf = BindLeaf(branchName);
+        return [=](NTupleCursor& cursor, const int& idx){return cursor.GetValue(leaf, 0);};
     }
 
     else{
-        bName = StrUtil::Replace(bName, "[P]", part.get_child_optional("branch-prefix") ? part.get<std::string>("branch-prefix") : part.get<std::string>("name"));
-
-        TLeaf* leaf = RUtil::Get<TLeaf>(inputTree, bName);
+        std::size_t leaf = BindLeaf(StrUtil::Replace(branchName, "[P]", part->prefix));
+        std::size_t partSlot = GetPartSlot(part->hash);
 
-        std::size_t partHash = part.get<std::size_t>("hash");
-
-        return [=, this](const int& entry, const int& idx)
-                 {return RUtil::GetEntry<float>(leaf, entry, GetWPIndex(entry, partHash, idx));};
+        return [=](NTupleCursor& cursor, const int& idx)
+                 {return cursor.GetValue(leaf, cursor.GetWPIndex(partSlot, idx));};
     }
 }
 
-Func NTupleReader::CreateCustomFunc(const std::string& customFunc, const std::vector<pt::ptree>& parts){
+Func NTupleReader::CreateCustomFunc(const FuncInfo& function, const std::vector<const PartInfo*>& parts){
+    const std::string& customFunc = function.alias;
     std::vector<std::string> neededBranches;
 
-    for(const std::string& fAlias: NTupleReader::GetVector(funcInfo.get_child(NTupleReader::GetName(funcInfo, customFunc) + ".need"))){
+    for(const std::string& fAlias: function.need){
         //Check if sub function configured
-        std::string fName = NTupleReader::GetName(funcInfo, fAlias);
+        const FuncInfo* subFunc = CompileFunc(fAlias);
+        if(subFunc == nullptr) throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Unknown function alias '", fAlias, "' needed by '", customFunc, "'!")); 
 
-        for(const pt::ptree& part : parts){
-            std::string needBranch = funcInfo.get<std::string>(fName + "." + "branch");
-            needBranch = StrUtil::Replace(needBranch, "[P]", part.get_child_optional("branch-prefix") ? part.get<std::string>("branch-prefix") : part.get<std::string>("name"));
-            neededBranches.push_back(std::move(needBranch));
+        for(const PartInfo* part : parts){
+            neededBranches.push_back(StrUtil::Replace(subFunc->branch, "[P]", part->prefix));
         }
 
         if(parts.size() == 0){
-            neededBranches.push_back(funcInfo.get<std::string>(fName + "." + "branch"));
+            neededBranches.push_back(subFunc->branch);
         }
     }
 
     if(customFunc == "N"){
-        std::size_t pHash = parts.at(0).get<std::size_t>("hash");
-        TLeaf* nPart = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
+        std::size_t pSlot = GetPartSlot(parts.at(0)->hash);
+        std::size_t nPart = BindLeaf(neededBranches.at(0));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::NParticles(entry, pHash, nPart);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return NParticles(cursor, pSlot, nPart);};
     }
 
     else if(customFunc == "HT"){
-        std::size_t jHash = parts.at(0).get<std::size_t>("hash");
-        TLeaf* jBranch = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
+        std::size_t jSlot = GetPartSlot(parts.at(0)->hash);
+        std::size_t jBranch = BindLeaf(neededBranches.at(0));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::HT(entry, jHash, jBranch);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return HT(cursor, jSlot, jBranch);};
     }
 
     else if(customFunc == "dphi"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash);
+        std::size_t p2Idx = parts.at(1)->idx;
 
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
+        std::size_t phi1 = BindLeaf(neededBranches.at(0));
+        std::size_t phi2 = BindLeaf(neededBranches.at(1));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::dPhi(entry, idx, p2Idx, p1Hash, p2Hash, phi1, phi2);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return dPhi(cursor, idx, p2Idx, p1Slot, p2Slot, phi1, phi2);};
     }
 
     else if(customFunc == "dicharge"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash);
+        std::size_t p2Idx = parts.at(1)->idx;
 
-        TLeaf* c1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* c2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
+        std::size_t c1 = BindLeaf(neededBranches.at(0));
+        std::size_t c2 = BindLeaf(neededBranches.at(1));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::diCharge(entry, idx, p2Idx, p1Hash, p2Hash, c1, c2);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return diCharge(cursor, idx, p2Idx, p1Slot, p2Slot, c1, c2);};
     }
 
     else if(customFunc == "dR"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash);
+        std::size_t p2Idx = parts.at(1)->idx;
 
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
-        TLeaf* eta1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(2));
-        TLeaf* eta2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(3));
+        std::size_t phi1 = BindLeaf(neededBranches.at(0));
+        std::size_t phi2 = BindLeaf(neededBranches.at(1));
+        std::size_t eta1 = BindLeaf(neededBranches.at(2));
+        std::size_t eta2 = BindLeaf(neededBranches.at(3));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::dR(entry, idx, p2Idx, p1Hash, p2Hash, phi1, phi2, eta1, eta2);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return dR(cursor, idx, p2Idx, p1Slot, p2Slot, phi1, phi2, eta1, eta2);};
     }
 
     else if(customFunc == "dR3"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash"), p3Hash = parts.at(2).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx"), p3Idx = parts.at(2).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash), p3Slot = GetPartSlot(parts.at(2)->hash);
+        std::size_t p2Idx = parts.at(1)->idx, p3Idx = parts.at(2)->idx;
 
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
-        TLeaf* phi3 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(2));
-        TLeaf* eta1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(3));
-        TLeaf* eta2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(4));
-        TLeaf* eta3 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(5));
-        TLeaf* pt2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(7));
-        TLeaf* pt3 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(8));
+        std::size_t phi1 = BindLeaf(neededBranches.at(0));
+        std::size_t phi2 = BindLeaf(neededBranches.at(1));
+        std::size_t phi3 = BindLeaf(neededBranches.at(2));
+        std::size_t eta1 = BindLeaf(neededBranches.at(3));
+        std::size_t eta2 = BindLeaf(neededBranches.at(4));
+        std::size_t eta3 = BindLeaf(neededBranches.at(5));
+        std::size_t pt2 = BindLeaf(neededBranches.at(7));
+        std::size_t pt3 = BindLeaf(neededBranches.at(8));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::dR3(entry, idx, p2Idx, p3Idx, p1Hash, p2Hash, p3Hash, phi1, eta1, pt2, phi2, eta2, phi2, pt3, eta3);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return dR3(cursor, idx, p2Idx, p3Idx, p1Slot, p2Slot, p3Slot, phi1, eta1, pt2, phi2, eta2, phi2, pt3, eta3);};
     }
 
 
     else if(customFunc == "dphi3"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash"), p3Hash = parts.at(2).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx"), p3Idx = parts.at(2).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash), p3Slot = GetPartSlot(parts.at(2)->hash);
+        std::size_t p2Idx = parts.at(1)->idx, p3Idx = parts.at(2)->idx;
 
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
-        TLeaf* phi3 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(2));
-        TLeaf* eta1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(3));
-        TLeaf* eta2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(4));
-        TLeaf* eta3 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(5));
-        TLeaf* pt2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(7));
-        TLeaf* pt3 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(8));
+        std::size_t phi1 = BindLeaf(neededBranches.at(0));
+        std::size_t phi2 = BindLeaf(neededBranches.at(1));
+        std::size_t phi3 = BindLeaf(neededBranches.at(2));
+        std::size_t eta1 = BindLeaf(neededBranches.at(3));
+        std::size_t eta2 = BindLeaf(neededBranches.at(4));
+        std::size_t eta3 = BindLeaf(neededBranches.at(5));
+        std::size_t pt2 = BindLeaf(neededBranches.at(7));
+        std::size_t pt3 = BindLeaf(neededBranches.at(8));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::dPhi3(entry, idx, p2Idx, p3Idx, p1Hash, p2Hash, p3Hash, phi1, pt2, phi2, eta2, phi2, pt3, eta3);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return dPhi3(cursor, idx, p2Idx, p3Idx, p1Slot, p2Slot, p3Slot, phi1, pt2, phi2, eta2, phi2, pt3, eta3);};
     }
 
     else if(customFunc == "diM"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash);
+        std::size_t p2Idx = parts.at(1)->idx;
 
-        TLeaf* pt1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* pt2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(2));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(3));
-        TLeaf* eta1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(4));
-        TLeaf* eta2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(5));
+        std::size_t pt1 = BindLeaf(neededBranches.at(0));
+        std::size_t pt2 = BindLeaf(neededBranches.at(1));
+        std::size_t phi1 = BindLeaf(neededBranches.at(2));
+        std::size_t phi2 = BindLeaf(neededBranches.at(3));
+        std::size_t eta1 = BindLeaf(neededBranches.at(4));
+        std::size_t eta2 = BindLeaf(neededBranches.at(5));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::diMass(entry, idx, p2Idx, p1Hash, p2Hash, pt1, pt2, phi1, phi2, eta1, eta2);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return diMass(cursor, idx, p2Idx, p1Slot, p2Slot, pt1, pt2, phi1, phi2, eta1, eta2);};
     }
 
     else if(customFunc == "diMT"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash"), p2Hash = parts.at(1).get<std::size_t>("hash");
-        std::size_t p2Idx = parts.at(1).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash), p2Slot = GetPartSlot(parts.at(1)->hash);
+        std::size_t p2Idx = parts.at(1)->idx;
 
-        TLeaf* pt1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* pt2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(2));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(3));
+        std::size_t pt1 = BindLeaf(neededBranches.at(0));
+        std::size_t pt2 = BindLeaf(neededBranches.at(1));
+        std::size_t phi1 = BindLeaf(neededBranches.at(2));
+        std::size_t phi2 = BindLeaf(neededBranches.at(3));
 
-        return [=, this](const int& entry, const int& idx)
-               {return diMT(entry, idx, p2Idx, p1Hash, p2Hash, pt1, pt2, phi1, phi2);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return diMT(cursor, idx, p2Idx, p1Slot, p2Slot, pt1, pt2, phi1, phi2);};
     }
 
     else if(customFunc == "LP"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash");
-        std::size_t p1Idx = parts.at(0).get<std::size_t>("idx");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash);
+        std::size_t p1Idx = parts.at(0)->idx;
 
-        TLeaf* pt1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
-        TLeaf* pt2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(1));
-        TLeaf* phi1 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(2));
-        TLeaf* phi2 = RUtil::Get<TLeaf>(inputTree, neededBranches.at(3));
+        std::size_t pt1 = BindLeaf(neededBranches.at(0));
+        std::size_t pt2 = BindLeaf(neededBranches.at(1));
+        std::size_t phi1 = BindLeaf(neededBranches.at(2));
+        std::size_t phi2 = BindLeaf(neededBranches.at(3));
 
-        return [=, this](const int& entry, const int& idx)
-               {return LP(entry, idx, p1Hash, pt1, pt2, phi1, phi2);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return LP(cursor, idx, p1Slot, pt1, pt2, phi1, phi2);};
     }
 
     else if(customFunc == "mEvNr"){
-        TLeaf* evNr = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
+        std::size_t evNr = BindLeaf(neededBranches.at(0));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::ModifiedEntry(entry, evNr);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return ModifiedEntry(cursor, evNr);};
     }
 
     else if(customFunc == "gM"){
-        std::size_t p1Hash = parts.at(0).get<std::size_t>("hash");
+        std::size_t p1Slot = GetPartSlot(parts.at(0)->hash);
 
-        TLeaf* gID = RUtil::Get<TLeaf>(inputTree, neededBranches.at(0));
+        std::size_t gID = BindLeaf(neededBranches.at(0));
 
-        return [=, this](const int& entry, const int& idx)
-               {return NTupleReader::isGenMatched(entry, idx, p1Hash, gID);};
+        return [=, this](NTupleCursor& cursor, const int& idx)
+               {return isGenMatched(cursor, idx, p1Slot, gID);};
     }
 
     else{
@@ -232,555 +227,751 @@ Func NTupleReader::CreateCustomFunc(const std::string& customFunc, const std::ve
     }
 }
 
-std::size_t NTupleReader::GetWPIndex(const std::size_t& entry, const std::size_t& partHash, const std::size_t& idx){
-    //Check if WP idx is needed
-    if(!partRequirements.count(partHash)) return idx;
+std::size_t NTupleReader::RegisterFunc(const std::string& signature, const Func& func, const std::size_t& idx){
+    //Same function already compiled by other histogram/cut/weight, share it
+    if(funcSlots.count(signature)) return funcSlots.at(signature);
+
+    funcSlots[signature] = sharedFuncs.size();
+    sharedFuncs.push_back(func);
+    sharedIdx.push_back(idx);
+    cursor.Sync();
+
+    return funcSlots.at(signature);
+}
+
+NTupleReader::NTupleReader(const std::vector<std::shared_ptr<TTree>>& inputTrees, const std::size_t& era, const std::experimental::source_location& location) :
+    era(era),
+    config(&NTupleConfig::Get()),
+    cursor(*this, inputTrees, location){
+
+    //Functions are compiled against the first tree
+    chanPrefix = !StrUtil::Find(inputTrees.at(0)->GetName(), "Ele").empty() ? "Ele" : "Muon";
+}
+
+std::size_t NTupleReader::BindLeaf(const std::string& branchName){
+    //Each leaf is only bound once and shared by all functions
+    if(leafSlots.count(branchName)) return leafSlots.at(branchName);
+
+    //Resolve leaf before registering it, so an unknown branch does not break the binding of all later leafs
+    RUtil::Get<TLeaf>(cursor.inputTree, branchName);
+
+    leafSlots[branchName] = leafNames.size();
+    leafNames.push_back(branchName);
 
-    //Check if idx already calculated for this particle
-    try{
-        return idxCache.at({partHash, idx});
+    cursor.Sync();
+
+    return leafSlots.at(branchName);
+}
+
+std::size_t NTupleReader::GetPartSlot(const std::size_t& partHash){
+    //Particles without requirements have no selection slot
+    if(!partSlots.count(partHash)) return std::numeric_limits<std::size_t>::max();
+
+    return partSlots.at(partHash);
+}
+
+NTupleCursor::NTupleCursor(const NTupleReader& reader, const std::vector<std::shared_ptr<TTree>>& inputTrees, const std::experimental::source_location& location) :
+    reader(&reader){
+
+    if(inputTrees.empty()) throw std::runtime_error(StrUtil::PrettyError(location, "No input tree is given!"));
+
+    for(const std::shared_ptr<TTree>& tree : inputTrees){
+        if(tree == nullptr) throw std::runtime_error(StrUtil::PrettyError(location, "Null pointer is given as input tree!"));
+
+        trees.push_back(tree.get());
+        treeLeafs.push_back({});
     }
 
-    catch(...){}
+    inputTree = trees.at(0);
+    isChain = inputTree->InheritsFrom(TChain::Class());
 
-    //Get TLeaf with size
-    std::size_t size = RUtil::GetEntry<std::size_t>(partSize.at(partHash), entry);
-    if(idx >= size) return std::numeric_limits<std::size_t>::max();
+    Sync();
+}
 
-    //Check if prevouis index alrealdy exist    
-    std::size_t start = idxCache.count({partHash, idx - 1}) ? idxCache.at({partHash, idx - 1}) + 1 : 0;
-    std::size_t counter = start == 0 ? 0 : idx;
+void NTupleCursor::Sync(){
+    //Grow buffers to everything compiled in the reader since the last call
+    for(std::size_t slot = leafBuffers.size(); slot < reader->leafNames.size(); ++slot){
+        LeafBuffer leaf;
+        leaf.name = reader->leafNames[slot];
+        RebindLeaf(leaf, inputTree);
 
-    std::size_t wpIdx = std::numeric_limits<std::size_t>::max();
+        for(std::size_t t = 0; t < trees.size(); ++t){
+            treeLeafs[t].push_back(t == treeIdx ? leaf.leaf : nullptr);
+        }
 
-    //Loop over all entries in collection
-    for(std::size_t i = start; i < size; ++i){
-        bool passed = true;
+        leafBuffers.push_back(std::move(leaf));
+    }
 
-        //Check if all id cuts are passed
-        for(std::pair<Cut, Func>& partCriteria : partRequirements.at(partHash)){
-            Cut& cut = partCriteria.first;
-            Func& func = partCriteria.second;
+    while(selectedIdx.size() < reader->partRequirements.size()){
+        selectedIdx.push_back(std::vector<std::size_t>());
+        selectedIdx.back().reserve(20);
+        selectedEntry.push_back(std::numeric_limits<std::size_t>::max());
+    }
 
-            passed = passed && cut(func(entry, i));
-            if(!passed) break;
+    sharedEntry.resize(reader->sharedFuncs.size(), std::numeric_limits<std::size_t>::max());
+    sharedValues.resize(reader->sharedFuncs.size(), -999.);
+}
+
+void NTupleCursor::RebindLeaf(LeafBuffer& leaf, TTree* tree){
+    leaf.leaf = RUtil::Get<TLeaf>(tree, leaf.name);
+    leaf.isFloat = std::string(leaf.leaf->GetTypeName()) == "Float_t";
+    leaf.entry = std::numeric_limits<std::size_t>::max();
+}
+
+void NTupleCursor::Invalidate(){
+    //Entry numbers are only unique within one tree, so drop everything memoized
+    for(LeafBuffer& leaf : leafBuffers) leaf.entry = std::numeric_limits<std::size_t>::max();
+
+    std::fill(selectedEntry.begin(), selectedEntry.end(), std::numeric_limits<std::size_t>::max());
+    std::fill(sharedEntry.begin(), sharedEntry.end(), std::numeric_limits<std::size_t>::max());
+
+    loadedEntry = std::numeric_limits<std::size_t>::max();
+}
+
+void NTupleCursor::SetEntry(const std::size_t& entry){
+    this->entry = entry;
+
+    if(sharedEntry.size() != reader->sharedFuncs.size() or leafBuffers.size() != reader->leafNames.size() or selectedIdx.size() != reader->partRequirements.size()) Sync();
+}
+
+void NTupleCursor::SetTree(const std::size_t& treeIdx){
+    if(treeIdx == this->treeIdx) return;
+
+    this->treeIdx = treeIdx;
+    inputTree = trees.at(treeIdx);
+    treeNumber = -1;
+
+    //Only the leaf bindings are switched, the compiled functions stay untouched
+    for(std::size_t slot = 0; slot < leafBuffers.size(); ++slot){
+        if(treeLeafs[treeIdx][slot] == nullptr){
+            RebindLeaf(leafBuffers[slot], inputTree);
+            treeLeafs[treeIdx][slot] = leafBuffers[slot].leaf;
         }
 
-        if(passed){
-            if(counter == idx){
-                wpIdx = i;
-                break;
-            }
+        else{
+            leafBuffers[slot].leaf = treeLeafs[treeIdx][slot];
+            leafBuffers[slot].isFloat = std::string(leafBuffers[slot].leaf->GetTypeName()) == "Float_t";
+        }
+    }
+
+    Invalidate();
+}
+
+void NTupleCursor::LoadEntry(const std::size_t& entry, const std::experimental::source_location& location){
+    loadedEntry = entry;
+    treeEntry = entry;
+
+    if(!isChain) return;
+
+    long long localEntry = inputTree->LoadTree(entry);
+    if(localEntry < 0) throw std::runtime_error(StrUtil::PrettyError(location, "Entry ", entry, " is not in the chain '", inputTree->GetName(), "'!"));
 
-            ++counter;
+    treeEntry = localEntry;
+
+    //Leafs of the previous file are deleted with it, so rebind all leafs by name to the new file
+    if(inputTree->GetTreeNumber() != treeNumber){
+        treeNumber = inputTree->GetTreeNumber();
+
+        for(LeafBuffer& leaf : leafBuffers) RebindLeaf(leaf, inputTree->GetTree());
+    }
+}
+
+const NTupleCursor::LeafBuffer& NTupleCursor::LoadLeaf(const std::size_t& leafSlot){
+    if(entry != loadedEntry) LoadEntry(entry);
+
+    LeafBuffer& leaf = leafBuffers[leafSlot];
+
+    //Check if branch already read for this entry
+    if(leaf.entry == entry) return leaf;
+
+    TBranch* branch = leaf.leaf->GetBranch();
+    if(branch->GetReadEntry() != treeEntry) branch->GetEntry(treeEntry);
+
+    leaf.size = leaf.leaf->GetLen();
+
+    //Float leafs are read directly from the ROOT buffer, other types are converted once
+    if(leaf.isFloat) leaf.data = static_cast<const float*>(leaf.leaf->GetValuePointer());
+
+    else{
+        leaf.buffer.resize(leaf.size);
+
+        for(std::size_t i = 0; i < leaf.size; ++i) leaf.buffer[i] = leaf.leaf->GetValue(i);
+        leaf.data = leaf.buffer.data();
+    }
+
+    leaf.entry = entry;
+
+    return leaf;
+}
+
+void NTupleCursor::SetupCache(const std::size_t& entryStart, const std::size_t& entryEnd, const std::vector<std::string>& extraBranches, const long long& cacheSize){
+    std::vector<std::string> branchNames = extraBranches;
+
+    //Collect branches of all bound leafs and their size leafs
+    for(const LeafBuffer& leaf : leafBuffers){
+        branchNames.push_back(leaf.leaf->GetBranch()->GetName());
+
+        if(leaf.leaf->GetLeafCount() != nullptr){
+            branchNames.push_back(leaf.leaf->GetLeafCount()->GetBranch()->GetName());
         }
     }
 
-    if(wpIdx != std::numeric_limits<std::size_t>::max()){
-        idxCache[{partHash, idx}] = wpIdx;
+    std::sort(branchNames.begin(), branchNames.end());
+    branchNames.erase(std::unique(branchNames.begin(), branchNames.end()), branchNames.end());
+
+    //Only read needed branches
+    inputTree->SetBranchStatus("*", 0);
+
+    for(const std::string& branchName : branchNames){
+        inputTree->SetBranchStatus(branchName.c_str(), 1);
+    }
+
+    //Prefill cache with exactly this set of branches
+    inputTree->SetCacheSize(cacheSize);
+
+    for(const std::string& branchName : branchNames){
+        inputTree->AddBranchToCache(branchName.c_str(), true);
     }
+
+    inputTree->SetCacheEntryRange(entryStart, entryEnd);
+    inputTree->StopCacheLearningPhase();
+
+    std::cout << "Read " << branchNames.size() << " branches with TTreeCache of size " << cacheSize/1e6 << " MB" << std::endl;
+}
+
+void NTupleCursor::SetEntryList(const std::vector<long long>& entries){
+    //Listed entries of a sparse loop, TTreeCache skips baskets without any listed entry
+    TEntryList* entryList = new TEntryList("entryList", "entryList", inputTree);
+    entryList->SetDirectory(nullptr);
+
+    //Entries of a TChain are global, the entry list splits them in sub lists for each file
+    for(const long long& entry : entries) entryList->Enter(entry, inputTree);
+
+    //Tree owns the list, it is deleted by the tree when replaced or when the tree is deleted
+    entryList->SetBit(TObject::kCanDelete);
+    inputTree->SetEntryList(entryList);
+}
+
+const std::vector<std::size_t>& NTupleCursor::SelectParticles(const std::size_t& partSlot){
+    std::vector<std::size_t>& selected = selectedIdx[partSlot];
+
+    //Check if selection already done for this entry
+    if(selectedEntry[partSlot] == entry) return selected;
+
+    selected.clear();
+
+    //Get size of collection
+    std::size_t size = GetValue(reader->partSize[partSlot], 0);
+
+    //Loop once over all entries in collection and keep all passing objects
+    for(std::size_t i = 0; i < size; ++i){
+        bool passed = true;
+
+        //Check if all id cuts are passed
+        for(const std::pair<Cut, Func>& partCriteria : reader->partRequirements[partSlot]){
+            const Cut& cut = partCriteria.first;
+            const Func& func = partCriteria.second;
+
+            passed = cut(func(*this, i));
+            if(!passed) break;
+        }
+
+        if(passed) selected.push_back(i);
+    }
+
+    selectedEntry[partSlot] = entry;
+
+    return selected;
+}
+
+std::size_t NTupleCursor::GetWPIndex(const std::size_t& partSlot, const std::size_t& idx){
+    //Check if WP idx is needed
+    if(partSlot == std::numeric_limits<std::size_t>::max()) return idx;
+
+    const std::vector<std::size_t>& selected = SelectParticles(partSlot);
   
-    return wpIdx;
+    return idx < selected.size() ? selected[idx] : std::numeric_limits<std::size_t>::max();
 }
 
-pt::ptree NTupleReader::SetPartWP(const pt::ptree& part, const std::string& wp, const std::size_t& idx){
-    pt::ptree setPart = part;
+const PartInfo& NTupleReader::CompilePart(const std::string& pName, const std::string& wp, const std::size_t& idx, const bool& isSelf){
+    //Already compiled, just return
+    std::tuple<std::string, std::string, std::size_t, bool> key = {pName, wp, idx, isSelf};
+    if(partIDs.count(key)) return partInfos[partIDs.at(key)];
 
-    //Set particle stuff
-    setPart.put("name", NTupleReader::GetName(partInfo, setPart.get<std::string>("alias")));
-    setPart.put("hash", std::hash<std::string>{}(wp + setPart.get<std::string>("name") + (part.get_child_optional("requirements") ? "req" : "") + + (part.get_child_optional("identification") ? "id" : "")));
-    setPart.put("wp", wp);
-    setPart.put("idx", idx > 0 ? idx - 1 : idx);
+    const pt::ptree& node = config->GetPartInfo().get_child(pName);
+    bool hasID = bool(node.get_child_optional("identification")), hasReq = bool(node.get_child_optional("requirements"));
+
+    PartInfo part;
+    part.name = pName;
+    part.prefix = node.get<std::string>("branch-prefix", pName);
+    part.size = node.get<std::string>("size", "");
+    part.idx = idx > 0 ? idx - 1 : idx;
+
+    //Self is the particle without identification and requirements (for branch reading)
+    part.hash = isSelf ? std::hash<std::string>{}(pName) : std::hash<std::string>{}(wp + pName + (hasReq ? "req" : "") + (hasID ? "id" : ""));
+
+    //Set neccesary part infos
+    part.histName = StrUtil::Replace(node.get<std::string>("hist-name", ""), "[WP]", wp);
+    part.axisName = StrUtil::Replace(node.get<std::string>("axis-name", ""), "[WP]", wp);
+
+    if(idx == 0){
+        part.histName = StrUtil::Replace(part.histName, "[I]", "");
+        part.axisName = StrUtil::Replace(part.axisName, "[I]", "");
+    }
+
+    else{
+        part.histName = StrUtil::Replace(part.histName, "[I]", idx);
+        part.axisName = StrUtil::Replace(part.axisName, "[I]", idx);
+    }
+
+    if(!isSelf and hasReq) part.requirements = &node.get_child("requirements");
 
     //Set proper cuts for WP of particles if needed
-    if(part.get_child_optional("identification") and wp != ""){
+    if(!isSelf and hasID and wp != ""){
         //Loop over all identification criteria
-        for(const std::string& idName : NTupleReader::GetKeys(part.get_child("identification"))){
-            //WP value with era
-            if(part.get_optional<float>(StrUtil::Join(".", "identification", idName, "WP", wp, "value", era))){
-                setPart.put(StrUtil::Merge("identification.", idName, ".value"), 
-                            part.get<float>(StrUtil::Join(".", "identification", idName, "WP", wp, "value", era)));
-            }
+        for(const std::pair<const std::string, pt::ptree>& id : node.get_child("identification")){
+            boost::optional<const pt::ptree&> wpInfo = id.second.get_child_optional(StrUtil::Join(".", "WP", wp));
+            if(!wpInfo) continue;
 
-            //WP value with era
-            else if(part.get_optional<float>(StrUtil::Join(".", "identification", idName, "WP", wp, "value"))){
-                setPart.put(StrUtil::Merge("identification.", idName, ".value"), 
-                            part.get<float>(StrUtil::Join(".", "identification", idName, "WP", wp, "value")));
-            }
+            //WP value with era, otherwise without era
+            boost::optional<float> value = wpInfo->get_optional<float>(StrUtil::Join(".", "value", era));
+            if(!value) value = wpInfo->get_optional<float>("value");
 
             //No WP for this particular case
-            else{
-                setPart.get_child("identification").erase(idName);
-                continue;
-            }
+            if(!value) continue;
 
-            setPart.put(StrUtil::Merge("identification.", idName, ".compare"), 
-                        part.get<std::string>(StrUtil::Join(".", "identification", idName, "WP", wp, "compare")));
-            setPart.get_child("identification." + idName).erase("WP");
+            part.identification.push_back({id.first, wpInfo->get<std::string>("compare"), *value});
         }
     }
 
-    else setPart.erase("identification");
+    partIDs[key] = partInfos.size();
+    partInfos.push_back(std::move(part));
 
-    return setPart;
+    return partInfos.back();
 }
 
-void NTupleReader::RegisterParticle(const pt::ptree& part){
+const FuncInfo* NTupleReader::CompileFunc(const std::string& fAlias){
+    //Already compiled, just return
+    std::pair<std::string, bool> key = {fAlias, false};
+    if(funcIDs.count(key)) return &funcInfos[funcIDs.at(key)];
+
+    std::string fName = config->GetFuncName(fAlias);
+    if(fName == "") return nullptr;
+
+    const pt::ptree& node = config->GetFuncInfo().get_child(fName);
+
+    FuncInfo function;
+    function.alias = fAlias;
+    function.branch = node.get<std::string>("branch", "");
+    function.histName = node.get<std::string>("hist-name", "");
+    function.axisName = node.get<std::string>("axis-name", "");
+    function.isCustom = bool(node.get_child_optional("need"));
+    if(function.isCustom) function.need = NTupleReader::GetVector(node.get_child("need"));
+
+    funcIDs[key] = funcInfos.size();
+    funcInfos.push_back(std::move(function));
+
+    return &funcInfos.back();
+}
+
+const FuncInfo& NTupleReader::CompileBranchFunc(const std::string& branchName){
+    //Already compiled, just return
+    std::pair<std::string, bool> key = {branchName, true};
+    if(funcIDs.count(key)) return funcInfos[funcIDs.at(key)];
+
+    FuncInfo function;
+    function.alias = branchName;
+    function.branch = branchName;
+    function.histName = branchName;
+    function.axisName = branchName;
+
+    funcIDs[key] = funcInfos.size();
+    funcInfos.push_back(std::move(function));
+
+    return funcInfos.back();
+}
+
+void NTupleReader::RegisterParticle(const PartInfo& part){
     //Already registered, just return
-    if(partRequirements.count(part.get<std::size_t>("hash"))) return;
+    if(partSlots.count(part.hash)) return;
 
     std::vector<std::pair<Cut, Func>> cuts;
 
     //Self with no requirements (for branch reading)
-    pt::ptree self = partInfo.get_child(NTupleReader::GetName(partInfo, part.get<std::string>("alias")));
-    self.erase("identification");
-    self.erase("requirements");
-    self = SetPartWP(self, "", 0);
-
-    if(part.get_child_optional("identification")){
-        //Loop over all basic idenfication requirements there only branch reading is needed
-        for(const std::string& idName : NTupleReader::GetKeys(part.get_child("identification"))){
-            Func func = CreateFunc(idName, self);
-            Cut cut = CreateCut(part.get<std::string>("identification." + idName + ".compare"), 
-                                part.get<float>("identification." + idName + ".value"));
+    const PartInfo& self = CompilePart(part.name, "", 0, true);
 
-            cuts.push_back(std::make_pair(std::move(cut), std::move(func)));
-        }
+    //Loop over all basic idenfication requirements there only branch reading is needed
+    for(const std::tuple<std::string, std::string, float>& id : part.identification){
+        Func func = CreateFunc(std::get<0>(id), &self);
+        Cut cut = CreateCut(std::get<1>(id), std::get<2>(id));
+
+        cuts.push_back(std::make_pair(std::move(cut), std::move(func)));
     }
 
-    if(part.get_child_optional("requirements")){
+    if(part.requirements != nullptr){
         //Loop over all other requirements with other particles involved and custom functions
-        for(const std::string& fAlias : NTupleReader::GetKeys(part.get_child("requirements"))){
-            std::string fName = NTupleReader::GetName(funcInfo, fAlias);
+        for(const std::pair<const std::string, pt::ptree>& requirement : *part.requirements){
+            const std::string& fAlias = requirement.first;
+
+            const FuncInfo* function = CompileFunc(fAlias);
+            if(function == nullptr) throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Unknown function alias '", fAlias, "' in requirements of '", part.name, "'!")); 
 
             //Make cut function
-            Cut cut = CreateCut(part.get<std::string>("requirements." + fAlias + ".compare"),
-                                part.get<float>("requirements." + fAlias + ".value"));
+            Cut cut = CreateCut(requirement.second.get<std::string>("compare"), requirement.second.get<float>("value"));
     
             Func func;
 
-            std::vector<pt::ptree> reqParts;
-            reqParts.push_back(self);
+            std::vector<const PartInfo*> reqParts = {&self};
 
             //Loop over all additional particles
-            if(part.get_child_optional("requirements." + fAlias + ".particles")){
-                pt::ptree requirements = part.get_child("requirements." + fAlias + ".particles");
-
-                for(const std::string& pAlias : NTupleReader::GetKeys(requirements)){
-                    pt::ptree reqPart;
-
-                    //Set idx, working point and hash for channel dependent part
-                    if(requirements.get_child_optional(pAlias + "." + chanPrefix)){
-                        reqPart = partInfo.get_child(NTupleReader::GetName(partInfo, requirements.get<std::string>(pAlias + "." + chanPrefix + ".partName")));
-
-                        reqPart = SetPartWP(reqPart, 
-                                            requirements.get<std::string>(pAlias + "." + chanPrefix + ".wp"),
-                                            requirements.get<std::size_t>(pAlias + "." + chanPrefix + ".idx"));
-                    }
-
-                    //Not channel dependent
-                    else{
-                        reqPart = partInfo.get_child(requirements.get<std::string>(pAlias + ".partName"));
+            if(requirement.second.get_child_optional("particles")){
+                for(const std::pair<const std::string, pt::ptree>& reqInfo : requirement.second.get_child("particles")){
+                    //Set idx, working point and hash for channel dependent part, otherwise not channel dependent
+                    const pt::ptree& info = reqInfo.second.get_child_optional(chanPrefix) ? reqInfo.second.get_child(chanPrefix) : reqInfo.second;
+                    std::string pName = reqInfo.second.get_child_optional(chanPrefix) ? config->GetPartName(info.get<std::string>("partName")) : info.get<std::string>("partName");
 
-                        reqPart = SetPartWP(reqPart, 
-                                            requirements.get<std::string>(pAlias + ".wp"),
-                                            requirements.get<std::size_t>(pAlias + ".idx"));
-                    }
+                    const PartInfo& reqPart = CompilePart(pName, info.get<std::string>("wp"), info.get<std::size_t>("idx"));
 
                     //Register needed particle if not already registered
                     RegisterParticle(reqPart); 
 
-                    reqParts.push_back(std::move(reqPart));
+                    reqParts.push_back(&reqPart);
                 } 
 
-                func = CreateCustomFunc(fAlias, reqParts);
+                func = CreateCustomFunc(*function, reqParts);
             }
 
             //No other particles are needed
             else{
-                if(funcInfo.get_child_optional(fName + "." + "need")){
-                    func = CreateCustomFunc(fAlias, reqParts);
-                }
-
-                else{
-                    std::string reqBranch = funcInfo.get<std::string>(fName + "." + "branch");
-                    func = CreateFunc(reqBranch, self);
-                }
+                if(function->isCustom) func = CreateCustomFunc(*function, reqParts);
+                else func = CreateFunc(function->branch, &self);
             }
 
             cuts.push_back(std::make_pair(std::move(cut), std::move(func)));
         }
     }
     
-    //Add to register
+    //Add to register and preallocate selection buffer of the default cursor
     if(!cuts.empty()){
-        partSize[part.get<std::size_t>("hash")] = RUtil::Get<TLeaf>(inputTree, part.get<std::string>("size"));
-        partRequirements[part.get<std::size_t>("hash")] = std::move(cuts);
+        partSlots[part.hash] = partRequirements.size();
+
+        partSize.push_back(BindLeaf(part.size));
+        partRequirements.push_back(std::move(cuts));
+        cursor.Sync();
     }
 }
 
 void NTupleFunction::AddParticle(const std::string& pAlias, const std::size_t& idx, const std::string& wp, const std::experimental::source_location& location){
-    std::string pName = NTupleReader::GetName(reader->partInfo, pAlias);
+    std::string pName = reader->config->GetPartName(pAlias);
 
     if(pName != ""){
-        pt::ptree particle = reader->partInfo.get_child(pName);
-
-        //Set neccesary part infos
-        particle.put("hist-name", StrUtil::Replace(particle.get<std::string>("hist-name"), "[WP]", wp));
-        particle.put("axis-name", StrUtil::Replace(particle.get<std::string>("axis-name"), "[WP]", wp));
-
-        if(idx == 0){
-            particle.put("axis-name", StrUtil::Replace(particle.get<std::string>("axis-name"), "[I]", ""));
-            particle.put("hist-name", StrUtil::Replace(particle.get<std::string>("hist-name"), "[I]", ""));
-        }
-
-        else{
-            particle.put("axis-name", StrUtil::Replace(particle.get<std::string>("axis-name"), "[I]", idx));
-            particle.put("hist-name", StrUtil::Replace(particle.get<std::string>("hist-name"), "[I]", idx));
-        }
-
-        particle = reader->SetPartWP(particle, wp, idx);
+        const PartInfo& particle = reader->CompilePart(pName, wp, idx);
         reader->RegisterParticle(particle);
 
-        
-
-        particles.push_back(std::move(particle));
+        particles.push_back(&particle);
     }
 
     else throw std::runtime_error(StrUtil::PrettyError(location, "Unknown particle alias: '", pAlias, "'!"));
 };
 
 void NTupleFunction::AddFunction(const std::string& fAlias, const std::vector<std::string>& values, const std::experimental::source_location& location){
-    std::string fName = NTupleReader::GetName(reader->funcInfo, fAlias);
-
     //Check if function configured
-    if(fName != ""){
-        function.insert(function.end(), reader->funcInfo.get_child(fName).begin(), reader->funcInfo.get_child(fName).end());
-
-        if(!values.empty()){
-            NTupleReader::PutVector(function, "values", values);
-        }
-    }
+    function = reader->CompileFunc(fAlias);
 
+    if(function != nullptr) this->values = values;
     else throw std::runtime_error(StrUtil::PrettyError(location, "Unknown function alias: '", fAlias, "'!"));
 };
 
 void NTupleFunction::AddFunctionByBranchName(const std::string& branchName, const std::experimental::source_location& location){
-    //Check if function configured
-    function.put("branch", branchName);
-    function.put("axis-name", branchName);
-    function.put("hist-name", branchName);
+    function = &reader->CompileBranchFunc(branchName);
 };
 
 void NTupleFunction::AddCut(const float& value, const std::string& op, const std::experimental::source_location& location){
-    function.put("cut-op", op);
-    function.put("cut-value", value);
+    cutOp = op;
+    cutValues = {value};
 }
 
 void NTupleFunction::AddCut(const std::vector<float>& values, const std::string& op, const std::experimental::source_location& location){
-    function.put("cut-op", op);
-    NTupleReader::PutVector(function, "cut-values", values);
+    cutOp = op;
+    cutValues = values;
 }
 
-Func NTupleFunction::compileBranchReading(const pt::ptree& part){
-    //Replace key holder for particle/value
-    if(!part.empty()){
-        function.put("axis-name", StrUtil::Replace(function.get<std::string>("axis-name"), "[P]", part.get<std::string>("axis-name")));
-        function.put("hist-name", StrUtil::Replace(function.get<std::string>("hist-name"), "[P]", part.get<std::string>("hist-name")));
-        function.put("branch", StrUtil::Replace(function.get<std::string>("branch"), "[P]", part.get_child_optional("branch-prefix") ? part.get<std::string>("branch-prefix") : part.get<std::string>("name")));
-    }
-
-    if(function.get_child_optional("values")){
-        std::vector<std::string> values = NTupleReader::GetVector(function.get_child("values"));
+void NTupleFunction::Compile(const std::experimental::source_location& location){
+    isCompiled = true;
 
-        for(const std::string& value : values){
-            function.put("axis-name", StrUtil::Replace(function.get<std::string>("axis-name"), "[V]", value));
-            function.put("hist-name", StrUtil::Replace(function.get<std::string>("hist-name"), "[V]", value));
-            function.put("branch", StrUtil::Replace(function.get<std::string>("branch"), "[V]", value));
-        }
+    if(function == nullptr){
+        throw std::runtime_error(StrUtil::PrettyError(location, "No function information avaible! Call 'AddFunction' before compiling!"));
     }
 
-    return reader->CreateFunc(function.get<std::string>("branch"), part);
-}
+    if(function->branch == "" and !function->isCustom){
+        throw std::runtime_error(StrUtil::PrettyError(location, "Function '", function->alias, "' has neither 'branch' nor 'need' configured!"));
+    }
 
-Func NTupleFunction::compileCustomFunction(const std::vector<pt::ptree>& parts){
-    //Get function values
-    std::vector<std::string> values;
-    if(function.get_child_optional("values")) values = NTupleReader::GetVector(function.get_child("values"));
+    //Replace key holder for particle/value, branch reading only uses first particle
+    std::string branch = function->branch;
+    histName = function->histName;
+    axisName = function->axisName;
+    mainIdx = particles.size() > 0 ? particles.at(0)->idx : 0;
 
-    //Label/axis name
-    for(const pt::ptree part: parts){
-        function.put("axis-name", StrUtil::Replace(function.get<std::string>("axis-name"), "[P]", part.get<std::string>("axis-name")));
-        function.put("hist-name", StrUtil::Replace(function.get<std::string>("hist-name"), "[P]", part.get<std::string>("hist-name")));
+    if(branch != ""){
+        if(particles.size() > 0){
+            axisName = StrUtil::Replace(axisName, "[P]", particles.at(0)->axisName);
+            histName = StrUtil::Replace(histName, "[P]", particles.at(0)->histName);
+            branch = StrUtil::Replace(branch, "[P]", particles.at(0)->prefix);
+        }
     }
 
-    for(const std::string value: values){
-        function.put("axis-name", StrUtil::Replace(function.get<std::string>("axis-name"), "[V]", value));
-        function.put("hist-name", StrUtil::Replace(function.get<std::string>("hist-name"), "[V]", value));
+    else{
+        for(const PartInfo* part : particles){
+            axisName = StrUtil::Replace(axisName, "[P]", part->axisName);
+            histName = StrUtil::Replace(histName, "[P]", part->histName);
+        }
     }
 
-    return reader->CreateCustomFunc(function.get<std::string>("alias"), parts);
-}
-
-void NTupleFunction::Compile(const std::experimental::source_location& location){
-    isCompiled = true;
-
-    if(function.empty()){
-        throw std::runtime_error(StrUtil::PrettyError(location, "No function information avaible! Call 'AddFunction' before compiling!"));
+    for(const std::string& value : values){
+        axisName = StrUtil::Replace(axisName, "[V]", value);
+        histName = StrUtil::Replace(histName, "[V]", value);
+        branch = StrUtil::Replace(branch, "[V]", value);
     }
 
-    //Only read out branch value with particle
-    if(function.get_child_optional("branch") and particles.size() > 0){
-        mainIdx = particles.at(0).get<std::size_t>("idx");
-        func = compileBranchReading(particles.at(0));
-    }
+    //Canonical signature of function with particles, WP and index to share it in the reader
+    std::string signature = branch != "" ? branch : function->alias;
 
-    //Only read out branch value without particle
-    else if(function.get_child_optional("branch")){
-        mainIdx = 0;
-        pt::ptree dummy;
-        func = compileBranchReading(dummy);
+    for(const PartInfo* part : particles){
+        signature = StrUtil::Merge(signature, "/", part->hash, ":", part->idx);
     }
 
-    //Compile external functions with particles
-    else if(function.get_child_optional("need") and particles.size() > 0){
-        mainIdx = particles.at(0).get<std::size_t>("idx");
-        func = compileCustomFunction(particles);
+    for(const std::string& value : values){
+        signature = StrUtil::Merge(signature, "/", value);
     }
 
-    //Compile external functions without particles
-    else if(function.get_child_optional("need")){
-        mainIdx = 0;
-        func = compileCustomFunction(particles);
-    }
+    this->signature = StrUtil::Merge(signature, "@", mainIdx);
+
+    //Only build the function if not already compiled by other histogram/cut/weight
+    if(reader->funcSlots.count(this->signature)) funcSlot = reader->funcSlots.at(this->signature);
 
     else{
-        throw std::runtime_error(StrUtil::PrettyError(location, "Function '", function.get<std::string>("alias"), "' has neither 'branch' nor 'need' configured!"));
+        Func func;
+
+        //Read out branch value with or without particle
+        if(branch != "") func = reader->CreateFunc(branch, particles.size() > 0 ? particles.at(0) : nullptr);
+
+        //External functions with or without particles
+        else func = reader->CreateCustomFunc(*function, particles);
+
+        funcSlot = reader->RegisterFunc(this->signature, func, mainIdx);
     }
 
+    func = reader->sharedFuncs[funcSlot];
+
     //Check if also cut should be compiled
-    if(function.get_optional<std::string>("cut-value")){
-        cut = reader->CreateCut(function.get<std::string>("cut-op"), function.get<float>("cut-value"));
+    if(cutValues.size() == 1){
+        cut = reader->CreateCut(cutOp, cutValues.at(0));
+        this->signature = StrUtil::Merge<9>(this->signature, " ", cutOp, " ", cutValues.at(0));
 
-        function.put("cut-name", StrUtil::Replace("[] [] []", "[]", function.get<std::string>("axis-name"), function.get<std::string>("cut-op"), function.get<std::string>("cut-value")));
+        cutName = StrUtil::Merge<7>(axisName, " ", cutOp, " ", cutValues.at(0));
     }
 
-    if(function.get_optional<std::string>("cut-values")){
+    else if(cutValues.size() > 1){
         std::vector<std::string> cutOps;
-        if(!StrUtil::Find(function.get<std::string>("cut-op"), "OR").empty()){
-            cutOps = StrUtil::Split(function.get<std::string>("cut-op"), "OR");
+        if(!StrUtil::Find(cutOp, "OR").empty()){
+            cutOps = StrUtil::Split(cutOp, "OR");
         }
 
-        else cutOps = StrUtil::Split(function.get<std::string>("cut-op"), "AND");
+        else cutOps = StrUtil::Split(cutOp, "AND");
 
-        std::vector<float> cutValues = NTupleReader::GetVector<float>(function.get_child("cut-values"));
-        cut = reader->CreateCut(function.get<std::string>("cut-op"), cutValues);
+        cut = reader->CreateCut(cutOp, cutValues);
+        this->signature = StrUtil::Merge(this->signature, " ", cutOp);
+        for(const float& value : cutValues) this->signature = StrUtil::Merge<9>(this->signature, " ", value);
 
-        function.put("cut-name", StrUtil::Replace("[] [] [] || [] [] []", "[]", function.get<std::string>("axis-name"), cutOps.at(0), cutValues.at(0), function.get<std::string>("axis-name"), cutOps.at(1), cutValues.at(1)));
+        cutName = StrUtil::Replace("[] [] [] || [] [] []", "[]", axisName, cutOps.at(0), cutValues.at(0), axisName, cutOps.at(1), cutValues.at(1));
     }
 }
 
 float NTupleFunction::Get(){
-    if(isCompiled) return func(reader->entry, mainIdx);
-    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'Get' function!"));
+    return Get(reader->cursor);
 }
 
 float NTupleFunction::Get(const std::size_t& index){
-    if(isCompiled) return func(reader->entry, index);
-    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'Get' function!"));
+    return Get(reader->cursor, index);
 }
 
 bool NTupleFunction::GetPassed(){
-    if(isCompiled) return cut(func(reader->entry, mainIdx));
-    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetPassed' function!"));
+    return GetPassed(reader->cursor);
 }
 
 bool NTupleFunction::GetPassed(const std::size_t& index){
-    if(isCompiled) return cut(func(reader->entry, index));
+    return GetPassed(reader->cursor, index);
+}
+
+float NTupleFunction::Get(NTupleCursor& cursor) const {
+    if(isCompiled) return cursor.GetShared(funcSlot);
+    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'Get' function!"));
+}
+
+float NTupleFunction::Get(NTupleCursor& cursor, const std::size_t& index) const {
+    if(isCompiled) return index == mainIdx ? cursor.GetShared(funcSlot) : func(cursor, index);
+    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'Get' function!"));
+}
+
+bool NTupleFunction::GetPassed(NTupleCursor& cursor) const {
+    if(isCompiled) return cut(cursor.GetShared(funcSlot));
+    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetPassed' function!"));
+}
+
+bool NTupleFunction::GetPassed(NTupleCursor& cursor, const std::size_t& index) const {
+    if(isCompiled) return cut(index == mainIdx ? cursor.GetShared(funcSlot) : func(cursor, index));
     else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetPassed' function!"));
 }
 
 std::string NTupleFunction::GetHistName(){
-    if(isCompiled) return function.get<std::string>("hist-name");
+    if(isCompiled) return histName;
     else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetHistName' function!"));
 }
 
 std::string NTupleFunction::GetAxisLabel(){
-    if(isCompiled) return function.get<std::string>("axis-name");
+    if(isCompiled) return axisName;
     else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetAxisLabel' function!"));
 }
 
+std::string NTupleFunction::GetSignature(){
+    if(isCompiled) return signature;
+    else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetSignature' function!"));
+}
+
 std::string NTupleFunction::GetCutName(){
-    if(isCompiled) return function.get<std::string>("cut-name");
+    if(isCompiled) return cutName;
     else throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Use the 'Compile' function before calling the 'GetCutName' function!"));
 }
 
-float NTupleReader::NParticles(const std::size_t& entry, const std::size_t& pHash, TLeaf* pSize){
-    std::size_t nPart = 0;
-    std::size_t nInitPart = RUtil::GetEntry<std::size_t>(pSize, entry);
-   
-    for(std::size_t i = 0; i < nInitPart; ++i){
-        if(GetWPIndex(entry, pHash, i) != std::numeric_limits<std::size_t>::max()) ++nPart;
-    }
+float NTupleReader::NParticles(NTupleCursor& cursor, const std::size_t& pSlot, const std::size_t& pSize) const {
+    if(pSlot == std::numeric_limits<std::size_t>::max()) return cursor.GetValue(pSize, 0);
 
-    return nPart;
+    return cursor.SelectParticles(pSlot).size();
 }
 
-float NTupleReader::HT(const std::size_t& entry, const std::size_t& jetHash, TLeaf* jetPt){
-    std::size_t nJets = RUtil::GetLen(jetPt, entry);
-
+float NTupleReader::HT(NTupleCursor& cursor, const std::size_t& jetSlot, const std::size_t& jetPt) const {
+    const NTupleCursor::LeafBuffer& pt = cursor.LoadLeaf(jetPt);
     float sumPt = 0.;
 
-    for(std::size_t i = 0; i < nJets; ++i){
-        std::size_t idx = GetWPIndex(entry, jetHash, i);
-    
-        if(idx != std::numeric_limits<std::size_t>::max()) sumPt += RUtil::GetEntry<float>(jetPt, entry, idx);
+    if(jetSlot == std::numeric_limits<std::size_t>::max()){
+        for(std::size_t i = 0; i < pt.size; ++i) sumPt += pt.data[i];
+    }
+
+    else{
+        for(const std::size_t& idx : cursor.SelectParticles(jetSlot)) sumPt += pt.data[idx];
     }
 
     return sumPt;
 }
 
-float NTupleReader::dR(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* phi1, TLeaf* phi2, TLeaf* eta1, TLeaf* eta2){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
+float NTupleReader::dR(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& phi1, const std::size_t& phi2, const std::size_t& eta1, const std::size_t& eta2) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max()){
-        return std::sqrt(std::pow(RUtil::GetEntry<float>(phi1, entry, p1WpIdx) - RUtil::GetEntry<float>(phi2, entry, p2WpIdx), 2) +
-                         std::pow(RUtil::GetEntry<float>(eta1, entry, p1WpIdx) - RUtil::GetEntry<float>(eta2, entry, p2WpIdx), 2));
+        return MUtil::DeltaR(cursor.GetValue(eta1, p1WpIdx), cursor.GetValue(phi1, p1WpIdx),
+                             cursor.GetValue(eta2, p2WpIdx), cursor.GetValue(phi2, p2WpIdx));
     }
 
     else return -999.;
 }
 
 
-float NTupleReader::diCharge(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* ch1, TLeaf* ch2){    
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
+float NTupleReader::diCharge(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& ch1, const std::size_t& ch2) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max()){
-        return RUtil::GetEntry<float>(ch1, entry, p1WpIdx) * RUtil::GetEntry<float>(ch2, entry, p2Idx);
+        return cursor.GetValue(ch1, p1WpIdx) * cursor.GetValue(ch2, p2Idx);
     }
 
     else return -999.;
 }
 
-float NTupleReader::dPhi(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* phi1, TLeaf* phi2){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
+float NTupleReader::dPhi(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& phi1, const std::size_t& phi2) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max()){
-        return std::acos(std::cos(RUtil::GetEntry<float>(phi1, entry, p1WpIdx))*std::cos(RUtil::GetEntry<float>(phi2, entry, p2WpIdx)) 
-                       + std::sin(RUtil::GetEntry<float>(phi1, entry, p1WpIdx))*std::sin(RUtil::GetEntry<float>(phi2, entry, p2WpIdx)));
+        return MUtil::DeltaPhi(cursor.GetValue(phi1, p1WpIdx), cursor.GetValue(phi2, p2WpIdx));
     }
 
     else return -999.;
 }
 
-float NTupleReader::dPhi3(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, const std::size_t& p3Hash, TLeaf* phi1, TLeaf* pt2, TLeaf* phi2, TLeaf* eta2, TLeaf* pt3, TLeaf* phi3, TLeaf* eta3){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
-    std::size_t p3WpIdx = GetWPIndex(entry, p3Hash, p3Idx);
+float NTupleReader::dPhi3(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& p3Slot, const std::size_t& phi1, const std::size_t& pt2, const std::size_t& phi2, const std::size_t& eta2, const std::size_t& pt3, const std::size_t& phi3, const std::size_t& eta3) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
+    std::size_t p3WpIdx = cursor.GetWPIndex(p3Slot, p3Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max() and p3WpIdx != std::numeric_limits<std::size_t>::max()){
-        ROOT::Math::PtEtaPhiMVector newP = ROOT::Math::PtEtaPhiMVector(
-                                                RUtil::GetEntry<float>(pt2, entry, p2WpIdx),
-                                                RUtil::GetEntry<float>(eta2, entry, p2WpIdx),
-                                                RUtil::GetEntry<float>(phi2, entry, p2WpIdx), 0.) +
-
-                                           ROOT::Math::PtEtaPhiMVector(
-                                                RUtil::GetEntry<float>(pt3, entry, p3WpIdx),
-                                                RUtil::GetEntry<float>(eta3, entry, p3WpIdx),
-                                                RUtil::GetEntry<float>(phi3, entry, p3WpIdx), 0.);
-
-        return std::acos(std::cos(newP.Phi())*std::cos(RUtil::GetEntry<float>(phi1, entry, p1WpIdx)) 
-                       + std::sin(newP.Phi())*std::sin(RUtil::GetEntry<float>(phi1, entry, p1WpIdx)));
+        std::array<float, 3> newP = MUtil::Sum(cursor.GetValue(pt2, p2WpIdx), cursor.GetValue(eta2, p2WpIdx), cursor.GetValue(phi2, p2WpIdx),
+                                               cursor.GetValue(pt3, p3WpIdx), cursor.GetValue(eta3, p3WpIdx), cursor.GetValue(phi3, p3WpIdx));
 
+        return MUtil::DeltaPhi(cursor.GetValue(phi1, p1WpIdx), newP[2]);
     }
 
     else return -999.;
 }
 
-float NTupleReader::dR3(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, const std::size_t& p3Hash, TLeaf* phi1, TLeaf* eta1, TLeaf* pt2, TLeaf* phi2, TLeaf* eta2, TLeaf* pt3, TLeaf* phi3, TLeaf* eta3){    
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
-    std::size_t p3WpIdx = GetWPIndex(entry, p3Hash, p3Idx);
+float NTupleReader::dR3(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p3Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& p3Slot, const std::size_t& phi1, const std::size_t& eta1, const std::size_t& pt2, const std::size_t& phi2, const std::size_t& eta2, const std::size_t& pt3, const std::size_t& phi3, const std::size_t& eta3) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
+    std::size_t p3WpIdx = cursor.GetWPIndex(p3Slot, p3Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max() and p3WpIdx != std::numeric_limits<std::size_t>::max()){
-        ROOT::Math::PtEtaPhiMVector newP = ROOT::Math::PtEtaPhiMVector(
-                                                RUtil::GetEntry<float>(pt2, entry, p2WpIdx),
-                                                RUtil::GetEntry<float>(eta2, entry, p2WpIdx),
-                                                RUtil::GetEntry<float>(phi2, entry, p2WpIdx), 0.) +
-
-                                           ROOT::Math::PtEtaPhiMVector(
-                                                RUtil::GetEntry<float>(pt3, entry, p3WpIdx),
-                                                RUtil::GetEntry<float>(eta3, entry, p3WpIdx),
-                                                RUtil::GetEntry<float>(phi3, entry, p3WpIdx), 0.);
-
-        return std::sqrt(std::pow(RUtil::GetEntry<float>(phi1, entry, p1WpIdx) - newP.Phi(), 2) +
-                         std::pow(RUtil::GetEntry<float>(eta1, entry, p1WpIdx) - newP.Eta(), 2));
+        std::array<float, 3> newP = MUtil::Sum(cursor.GetValue(pt2, p2WpIdx), cursor.GetValue(eta2, p2WpIdx), cursor.GetValue(phi2, p2WpIdx),
+                                               cursor.GetValue(pt3, p3WpIdx), cursor.GetValue(eta3, p3WpIdx), cursor.GetValue(phi3, p3WpIdx));
 
+        return MUtil::DeltaR(cursor.GetValue(eta1, p1WpIdx), cursor.GetValue(phi1, p1WpIdx), newP[1], newP[2]);
     }
 
     else return -999.;
 }
 
-float NTupleReader::diMass(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* pt1, TLeaf* pt2, TLeaf* phi1, TLeaf* phi2, TLeaf* eta1, TLeaf* eta2){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
+float NTupleReader::diMass(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& pt1, const std::size_t& pt2, const std::size_t& phi1, const std::size_t& phi2, const std::size_t& eta1, const std::size_t& eta2) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max()){
-        ROOT::Math::PtEtaPhiMVector p1(RUtil::GetEntry<float>(pt1, entry, p1WpIdx), 
-                                       RUtil::GetEntry<float>(eta1, entry, p1WpIdx),
-                                       RUtil::GetEntry<float>(phi1, entry, p1WpIdx), 0.);
-        ROOT::Math::PtEtaPhiMVector p2(RUtil::GetEntry<float>(pt2, entry, p2WpIdx), 
-                                       RUtil::GetEntry<float>(eta2, entry, p2WpIdx),
-                                       RUtil::GetEntry<float>(phi2, entry, p2WpIdx), 0.);
-
-
-        return (p1 + p2).M();
+        return MUtil::InvMass(cursor.GetValue(pt1, p1WpIdx), cursor.GetValue(eta1, p1WpIdx), cursor.GetValue(phi1, p1WpIdx), 0.,
+                              cursor.GetValue(pt2, p2WpIdx), cursor.GetValue(eta2, p2WpIdx), cursor.GetValue(phi2, p2WpIdx), 0.);
     }
     
     else return -999.;
 }
 
-float NTupleReader::diMT(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Hash, const std::size_t& p2Hash, TLeaf* pt1, TLeaf* pt2, TLeaf* phi1, TLeaf* phi2){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
-    std::size_t p2WpIdx = GetWPIndex(entry, p2Hash, p2Idx);
+float NTupleReader::diMT(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p2Idx, const std::size_t& p1Slot, const std::size_t& p2Slot, const std::size_t& pt1, const std::size_t& pt2, const std::size_t& phi1, const std::size_t& phi2) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
+    std::size_t p2WpIdx = cursor.GetWPIndex(p2Slot, p2Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max() and p2WpIdx != std::numeric_limits<std::size_t>::max()){
-        return std::sqrt(2*RUtil::GetEntry<float>(pt1, entry, p1WpIdx)*RUtil::GetEntry<float>(pt2, entry, p2WpIdx)*(
-               1 - std::cos(dPhi(entry, p1Idx, p2Idx, p1Hash, p2Hash, phi1, phi2))));
+        return MUtil::TransverseMass(cursor.GetValue(pt1, p1WpIdx), cursor.GetValue(phi1, p1WpIdx),
+                                     cursor.GetValue(pt2, p2WpIdx), cursor.GetValue(phi2, p2WpIdx));
     }
     
     else return -999.;
 }
 
 
-float NTupleReader::LP(const std::size_t& entry, const std::size_t& p1Idx, const std::size_t& p1Hash, TLeaf* pt1, TLeaf* ptMet, TLeaf* phi1, TLeaf* phiMet){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
+float NTupleReader::LP(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p1Slot, const std::size_t& pt1, const std::size_t& ptMet, const std::size_t& phi1, const std::size_t& phiMet) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
 
     if(p1WpIdx != std::numeric_limits<std::size_t>::max()){
-        ROOT::Math::PtEtaPhiMVector l(RUtil::GetEntry<float>(pt1, entry, p1WpIdx), 0, RUtil::GetEntry<float>(phi1, entry, p1WpIdx), 0);
-        ROOT::Math::PtEtaPhiMVector MET(RUtil::GetEntry<float>(ptMet, entry, 0), 0, RUtil::GetEntry<float>(phiMet, entry, 0), 0);
-        ROOT::Math::PtEtaPhiMVector W = l + MET;
-
-        float dPhi = l.phi() - W.phi();
-        while (dPhi >= TMath::Pi()) dPhi -= TMath::TwoPi();
-        while (dPhi < -TMath::Pi()) dPhi += TMath::TwoPi();
-
-        return l.pt()/W.pt()*std::cos(abs(dPhi));
+        return MUtil::LP(cursor.GetValue(pt1, p1WpIdx), cursor.GetValue(phi1, p1WpIdx), cursor.GetValue(ptMet, 0), cursor.GetValue(phiMet, 0));
     }
 
     else return -999.;
 }
 
 
-float NTupleReader::ModifiedEntry(const int& entry, TLeaf* evNr){
-    return 1./RUtil::GetEntry<float>(evNr, entry)*10e10;
+float NTupleReader::ModifiedEntry(NTupleCursor& cursor, const std::size_t& evNr) const {
+    return 1./cursor.GetValue(evNr, 0)*10e10;
 }
 
-float NTupleReader::isGenMatched(const int& entry, const std::size_t& p1Idx, const std::size_t& p1Hash, TLeaf* gID){
-    std::size_t p1WpIdx = GetWPIndex(entry, p1Hash, p1Idx);
+float NTupleReader::isGenMatched(NTupleCursor& cursor, const std::size_t& p1Idx, const std::size_t& p1Slot, const std::size_t& gID) const {
+    std::size_t p1WpIdx = cursor.GetWPIndex(p1Slot, p1Idx);
 
-    return RUtil::GetEntry<float>(gID, entry, p1WpIdx) > -20.;
+    return cursor.GetValue(gID, p1WpIdx) > -20.;
 }
@@ -0,0 +1,83 @@
+#include <ChargedAnalysis/Analysis/include/regionselector.h>
+
+std::size_t RegionSelector::AddRegion(const std::experimental::source_location& location){
+    if(nRegions == 64) throw std::runtime_error(StrUtil::PrettyError(location, "More than 64 regions are not supported!"));
+
+    allRegions |= std::uint64_t(1) << nRegions;
+
+    return nRegions++;
+}
+
+std::size_t RegionSelector::AddCut(const std::size_t& region, NTupleFunction cut){
+    std::string signature = cut.GetSignature();
+
+    //Cuts with same signature are shared by all regions
+    if(!cutSlots.count(signature)){
+        cutSlots[signature] = cuts.size();
+        order.push_back(cuts.size());
+
+        cuts.push_back(cut);
+        cutRegions.push_back(0);
+
+        nEvaluated.push_back(0);
+        nRejected.push_back(0);
+        nTimed.push_back(0);
+        evalTime.push_back(0.);
+    }
+
+    cutRegions[cutSlots[signature]] |= std::uint64_t(1) << region;
+
+    return cutSlots[signature];
+}
+
+void RegionSelector::Evaluate(){
+    passed = allRegions;
+
+    //All cuts see the same entry, so selected particles and loaded leafs are reused between the cuts
+    for(const std::size_t& c : order){
+        //Only evaluate cut, if entry is still in a region requiring the cut
+        if(!(passed & cutRegions[c])) continue;
+
+        bool cutPassed;
+
+        if(!isOrdered){
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            cutPassed = cuts[c].GetPassed();
+            evalTime[c] += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+            ++nTimed[c];
+        }
+
+        else cutPassed = cuts[c].GetPassed();
+
+        ++nEvaluated[c];
+
+        if(!cutPassed){
+            ++nRejected[c];
+            passed &= ~cutRegions[c];
+        }
+    }
+
+    //Reorder cuts once after the first events
+    if(!isOrdered and ++nSampled >= nSample) Reorder();
+}
+
+void RegionSelector::Reorder(){
+    //Expected cost per rejected event, cheap and strongly rejecting cuts first
+    std::vector<double> rank(cuts.size(), std::numeric_limits<double>::max());
+
+    for(std::size_t c = 0; c < cuts.size(); ++c){
+        if(nRejected[c] != 0) rank[c] = evalTime[c]/nRejected[c];
+    }
+
+    std::stable_sort(order.begin(), order.end(), [&](const std::size_t& c1, const std::size_t& c2){return rank[c1] < rank[c2];});
+    isOrdered = true;
+}
+
+void RegionSelector::Report(){
+    std::cout << std::endl << "Cut statistics in evaluation order" << std::endl;
+
+    for(const std::size_t& c : order){
+        std::cout << "Cut '" << cuts[c].GetCutName() << "': evaluated " << nEvaluated[c] << " events, rejected " << (nEvaluated[c] != 0 ? 100.*nRejected[c]/nEvaluated[c] : 0.) << " %, " << (nTimed[c] != 0 ? evalTime[c]/nTimed[c] : 0.) << " us/event" << std::endl;
+    }
+}
@@ -35,75 +35,87 @@ Weighter::Weighter(const std::shared_ptr<TFile>& inputFile, const std::shared_pt
         
     this->baseWeight = lumi/nGen;
 
-    //Read out pile up histograms
+    //Read out pile up histograms and store data/MC ratio for each number of true interactions
     if(inputFile->GetListOfKeys()->Contains("pileUp")){
         isData = false;
         std::shared_ptr<TH1F> puMC = RUtil::GetSmart<TH1F>(inputFile.get(), "puMC");
+        puMC->Scale(1./puMC->Integral());
 
-        pileUpWeight = RUtil::CloneSmart<TH1F>(RUtil::Get<TH1F>(inputFile.get(), "pileUp"));
-        pileUpWeightUp = RUtil::CloneSmart<TH1F>(RUtil::Get<TH1F>(inputFile.get(), "pileUpUp"));
-        pileUpWeightDown = RUtil::CloneSmart<TH1F>(RUtil::Get<TH1F>(inputFile.get(), "pileUpDown"));
+        for(const std::string shift : {"", "Up", "Down"}){
+            std::shared_ptr<TH1F> pileUp = RUtil::CloneSmart<TH1F>(RUtil::Get<TH1F>(inputFile.get(), "pileUp" + shift));
+            pileUp->Scale(1./pileUp->Integral());
+            pileUp->Divide(puMC.get());
 
-        pileUpWeight->Scale(1./pileUpWeight->Integral());
-        pileUpWeightUp->Scale(1./pileUpWeightUp->Integral());
-        pileUpWeightDown->Scale(1./pileUpWeightDown->Integral());
-        puMC->Scale(1./puMC->Integral());
+            std::vector<double>& ratio = shift == "" ? pileUpWeight : shift == "Up" ? pileUpWeightUp : pileUpWeightDown;
+
+            //Last element is the overflow bin
+            for(int nTrue = 0; nTrue <= std::ceil(pileUp->GetXaxis()->GetXmax()); ++nTrue){
+                ratio.push_back(pileUp->GetBinContent(pileUp->FindBin(nTrue)));
+            }
+        }
 
-        pileUpWeight->Divide(puMC.get());
-        pileUpWeightUp->Divide(puMC.get());
-        pileUpWeightDown->Divide(puMC.get());
+        nTrueInt = RUtil::Get<TLeaf>(inputTree.get(), "Weight_nTrueInt");
+        branchNames.push_back("Weight_nTrueInt");
     }
 }
 
-double Weighter::GetBJetWeight(const int& entry, TH2F* effB, TH2F* effC, TH2F* effLight, NTupleFunction& bPt, TLeaf* pt, TLeaf* eta, TLeaf* sf, TLeaf* flavour){
-    double wData = 1., wMC = 1.;
-    float jetPt, jetEta, trueFlav, scaleFactor, eff;
+void Weighter::SetBJetWeights(const std::size_t& entry){
+    if(bEntry == entry) return;
+    bEntry = entry;
 
-    int size = RUtil::GetLen(pt, entry);
-    int bIdx = 0;
+    int size = RUtil::GetLen(jetPt, entry);
+    RUtil::GetLen(jetEta, entry);
+    RUtil::GetLen(partonFlav, entry);
 
-    std::cout << "Event start" << std::endl;
+    for(TLeaf* sf : bSF) RUtil::GetLen(sf, entry);
 
-    for(std::size_t i = 0; i < size; ++i){
-        eff = 1.;
-        scaleFactor = RUtil::GetEntry<float>(sf, entry, i);
-        trueFlav = RUtil::GetEntry<int>(flavour, entry, i);
+    //Efficiency and tag decision for each jet, jets with efficiency of 0 or 1 do not contribute
+    bEff.resize(size);
+    bTagged.resize(size);
 
-        jetPt = RUtil::GetEntry<float>(pt, entry, i);
-        jetEta = RUtil::GetEntry<float>(eta, entry, i);
-        
-        if(std::abs(trueFlav) == 5) eff = effB->GetBinContent(effB->FindBin(jetPt, jetEta));
-        else if(std::abs(trueFlav) == 4) eff = effC->GetBinContent(effC->FindBin(jetPt, jetEta));
-        else eff = effLight->GetBinContent(effLight->FindBin(jetPt, jetEta));
+    for(int i = 0, bIdx = 0; i < size; ++i){
+        float pt = jetPt->GetValue(i), eta = jetEta->GetValue(i);
+        int trueFlav = std::abs(partonFlav->GetValue(i));
 
-        if(eff == 0 or eff == 1) continue;
+        if(trueFlav == 5) bEff[i] = effB.Get(pt, eta);
+        else if(trueFlav == 4) bEff[i] = effC.Get(pt, eta);
+        else bEff[i] = effLight.Get(pt, eta);
 
-        if(bPt.Get(bIdx) == jetPt){
-            wData *= scaleFactor * eff;
-            wMC *= eff;
-            ++bIdx;
-        }
-    
-        else{
-            wData *= (1 - scaleFactor*eff);
-            wMC *= (1 - eff);
+        if(bEff[i] == 0 or bEff[i] == 1){
+            bEff[i] = -1.;
+            continue;
         }
+
+        bTagged[i] = bPt->Get(bIdx) == pt;
+        if(bTagged[i]) ++bIdx;
     }
 
-    std::cout << "Event end" << std::endl;
+    //Probability ratio of data/MC for nominal, Up and Down scale factors
+    double wMC = 1.;
+    std::array<double, 3> wData = {1., 1., 1.};
+
+    for(int i = 0; i < size; ++i){
+        if(bEff[i] == -1.) continue;
+
+        wMC *= bTagged[i] ? bEff[i] : 1 - bEff[i];
 
-    return wData/wMC;
+        for(int shift = 0; shift < 3; ++shift){
+            float scaleFactor = bSF[shift]->GetValue(i);
+            wData[shift] *= bTagged[i] ? scaleFactor * bEff[i] : 1 - scaleFactor * bEff[i];
+        }
+    }
+
+    for(int shift = 0; shift < 3; ++shift) bWeights[shift] = wData[shift]/wMC;
 }
 
 void Weighter::AddParticle(const std::string& pAlias, const std::string& wp, NTupleReader& reader, const std::experimental::source_location& location){
     if(isData) return;
 
     //Read out information of SF branches for wished particle
-    pt::ptree partInfo;
-    pt::json_parser::read_json(StrUtil::Merge(std::getenv("CHDIR"), "/ChargedAnalysis/Analysis/data/particle.json"), partInfo);
+    const pt::ptree& partInfo = NTupleConfig::Get().GetPartInfo();
     
     //Check if sub function configured
-    std::string pName = NTupleReader::GetName(partInfo, pAlias);
+    std::string pName = NTupleConfig::Get().GetPartName(pAlias);
 
     if(pName == "") throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Unknown particle alias: '", pAlias, "'!"));
 
@@ -136,103 +148,144 @@ void Weighter::AddParticle(const std::string& pAlias, const std::string& wp, NTu
             }
 
             else{
-                std::string wpName = StrUtil::Capitilize(wp);
-
-                TH2F* effB = RUtil::Clone<TH2F>(RUtil::Get<TH2F>(inputFile.get(), StrUtil::Replace("n@BbTagDeepCSV", "@", wpName)));
-                effB->Divide(RUtil::Get<TH2F>(inputFile.get(), "nTrueB"));
-                TH2F* effC = RUtil::Clone<TH2F>(RUtil::Get<TH2F>(inputFile.get(), StrUtil::Replace("n@CbTagDeepCSV", "@", wpName)));
-                effC->Divide(RUtil::Get<TH2F>(inputFile.get(), "nTrueC"));
-                TH2F* effLight = RUtil::Clone<TH2F>(RUtil::Get<TH2F>(inputFile.get(), StrUtil::Replace("n@LightbTagDeepCSV", "@", wpName)));
-                effLight->Divide(RUtil::Get<TH2F>(inputFile.get(), "nTrueLight"));
-
-                NTupleFunction bPt = reader.BuildFunc();
-                bPt.AddParticle("bj", 0, wp);
-                bPt.AddFunction("pt");
-                bPt.Compile();
-
-                TLeaf* jetPt = RUtil::Get<TLeaf>(inputTree.get(), "Jet_Pt");
-                TLeaf* jetEta = RUtil::Get<TLeaf>(inputTree.get(), "Jet_Eta");
-                TLeaf* sf = RUtil::Get<TLeaf>(inputTree.get(), StrUtil::Replace(branchName, "[SHIFT]", shift));
-                TLeaf* partonFlav = RUtil::Get<TLeaf>(inputTree.get(), "Jet_PartonFlavour");
-
-                std::function<float(const int&)> bW = [=, bPt = std::move(bPt)](const int& entry) mutable {
-                return Weighter::GetBJetWeight(entry, effB, effC, effLight, bPt, jetPt, jetEta, sf, partonFlav);};
-            
-                if(shift == "") bWeight = bW;
-                else if(shift == "Up") bWeightUp = bW;
-                else if(shift == "Down") bWeightDown = bW;
+                //Efficiency maps and tagged jets are set up once, each shift only adds its scale factor branch
+                if(!bPt){
+                    std::string wpName = StrUtil::Capitilize(wp);
+
+                    std::shared_ptr<TH2F> hEffB = RUtil::CloneSmart<TH2F>(RUtil::Get<TH2F>(inputFile.get(), StrUtil::Replace("n@BbTagDeepCSV", "@", wpName)));
+                    hEffB->Divide(RUtil::Get<TH2F>(inputFile.get(), "nTrueB"));
+                    std::shared_ptr<TH2F> hEffC = RUtil::CloneSmart<TH2F>(RUtil::Get<TH2F>(inputFile.get(), StrUtil::Replace("n@CbTagDeepCSV", "@", wpName)));
+                    hEffC->Divide(RUtil::Get<TH2F>(inputFile.get(), "nTrueC"));
+                    std::shared_ptr<TH2F> hEffLight = RUtil::CloneSmart<TH2F>(RUtil::Get<TH2F>(inputFile.get(), StrUtil::Replace("n@LightbTagDeepCSV", "@", wpName)));
+                    hEffLight->Divide(RUtil::Get<TH2F>(inputFile.get(), "nTrueLight"));
+
+                    effB = RateTable(hEffB.get());
+                    effC = RateTable(hEffC.get());
+                    effLight = RateTable(hEffLight.get());
+
+                    bPt = std::make_shared<NTupleFunction>(reader.BuildFunc());
+                    bPt->AddParticle("bj", 0, wp);
+                    bPt->AddFunction("pt");
+                    bPt->Compile();
+
+                    jetPt = RUtil::Get<TLeaf>(inputTree.get(), "Jet_Pt");
+                    jetEta = RUtil::Get<TLeaf>(inputTree.get(), "Jet_Eta");
+                    partonFlav = RUtil::Get<TLeaf>(inputTree.get(), "Jet_PartonFlavour");
+
+                    branchNames = VUtil::Merge(branchNames, std::vector<std::string>{"Jet_Pt", "Jet_Eta", "Jet_PartonFlavour"});
+                }
+
+                TLeaf* sf = RUtil::Get<TLeaf>(inputTree.get(), branchName);
+                branchNames.push_back(sf->GetBranch()->GetName());
+
+                //Missing shifts fall back to the nominal scale factor
+                if(shift == "") bSF = {sf, bSF[1] ? bSF[1] : sf, bSF[2] ? bSF[2] : sf};
+                else bSF[shift == "Up" ? 1 : 2] = sf;
             }
         }
     }
 }
 
-int Weighter::GetNWeights(){return sf.size() + bool(bWeight);}
+int Weighter::GetNWeights(){return sf.size() + bool(bPt);}
 
 double Weighter::GetBaseWeight(const std::size_t& entry, const std::string& sysShift){
     if(isData) return 1.;
-    double puWeight = 1., stitchWeight = xSec;
 
-    if(pileUpWeight){
-        std::shared_ptr<TH1F>& pileUp = sysShift == "" ? pileUpWeight : sysShift == "Up" ? pileUpWeightUp : pileUpWeightDown;
+    //Weights of all pile up shifts are calculated once per entry
+    if(baseEntry != entry){
+        double stitchWeight = xSec;
+
+       /* if(nPartons != nullptr){
+            short n = RUtil::GetEntry<short>(nPartons, entry);
+
+            stitchWeight = stitchedWeights.at(n);
+        } */
+
+        baseWeights = {this->baseWeight*stitchWeight, this->baseWeight*stitchWeight, this->baseWeight*stitchWeight};
 
-        std::size_t bin = RUtil::GetEntry<short>(RUtil::Get<TLeaf>(inputTree.get(), "Weight_nTrueInt"), entry);
-        puWeight = pileUp->GetBinContent(pileUpWeight->FindBin(bin));
+        if(nTrueInt != nullptr){
+            std::size_t nTrue = std::min<std::size_t>(RUtil::GetEntry<short>(nTrueInt, entry), pileUpWeight.size() - 1);
+
+            baseWeights[0] *= pileUpWeight[nTrue];
+            baseWeights[1] *= pileUpWeightUp[nTrue];
+            baseWeights[2] *= pileUpWeightDown[nTrue];
+        }
+
+        baseEntry = entry;
     }
 
-   /* if(nPartons != nullptr){
-        short n = RUtil::GetEntry<short>(nPartons, entry);
+    return sysShift == "" ? baseWeights[0] : sysShift == "Up" ? baseWeights[1] : baseWeights[2];
+}
 
-        stitchWeight = stitchedWeights.at(n);
-    } */
+std::size_t Weighter::GetWeightIndex(const std::string& syst, const std::string& sysShift){
+    std::size_t shift = sysShift == "Up" ? 1 : 2;
 
-    return this->baseWeight*puWeight*stitchWeight;
+    if(syst == "BJet") return bPt ? 2*sf.size() + shift : 0;
+
+    //Nominal, PileUp or systematic of other particles
+    std::vector<int> systIdx = VUtil::Find(systematics, syst);
+    return systIdx.empty() ? 0 : 2*systIdx.at(0) + shift;
 }
 
-double Weighter::GetPartWeight(const std::size_t& entry, const std::string& syst, const std::string& sysShift){
-    if(isData) return 1.;
+const std::vector<double>& Weighter::GetPartWeights(const std::size_t& entry){
+    if(partEntry == entry) return partWeights;
+    partEntry = entry;
 
-    double partWeight = 1.;
+    partWeights.assign(1 + 2*sf.size() + 2*bool(bPt), 1.);
+    if(isData) return partWeights;
 
-    int systIdx;
+    //Product over all objects for each scale factor and its shifts, every value is read once
+    sfProducts.assign(sf.size(), {1., 1., 1.});
 
-    if(syst == "Nominal" or syst == "PileUp") systIdx = -1;
-    else if(syst == "BJet") systIdx = -2;
-    else{
-        try{
-            systIdx = VUtil::Find(systematics, syst).at(0);
-        }
-    
-        catch(...){
-            StrUtil::PrettyError(std::experimental::source_location::current(), "Unknown systematic '", syst, "'!");
+    for(int idx = 0; idx < sf.size(); ++idx){
+        for(int k = 0;; ++k){
+            float weight = sf[idx].Get(k);
+            if(weight == -999.) break;
+
+            float weightUp = idx < sfUp.size() ? sfUp[idx].Get(k) : weight;
+            float weightDown = idx < sfDown.size() ? sfDown[idx].Get(k) : weight;
+
+            sfProducts[idx][0] *= weight != 0 ? weight : 1.;
+            sfProducts[idx][1] *= weightUp != 0 and weightUp != -999. ? weightUp : 1.;
+            sfProducts[idx][2] *= weightDown != 0 and weightDown != -999. ? weightDown : 1.;
         }
     }
 
+    //Nominal product of all other scale factors from prefix and suffix products
+    sfPrefix.assign(sf.size() + 1, 1.);
+    sfSuffix.assign(sf.size() + 1, 1.);
+
     for(int idx = 0; idx < sf.size(); ++idx){
-        std::vector<NTupleFunction>* scale;
+        sfPrefix[idx + 1] = sfPrefix[idx] * sfProducts[idx][0];
+        sfSuffix[sf.size() - idx - 1] = sfSuffix[sf.size() - idx] * sfProducts[sf.size() - idx - 1][0];
+    }
 
-        if(systIdx != idx) scale = &sf;
-        else{
-            if(sysShift == "Up") scale = &sfUp;
-            else scale = &sfDown;
-        }
+    double nominal = sfPrefix[sf.size()], bNominal = 1.;
 
-        for(int k = 0;; ++k){
-            float weight = scale->at(idx).Get(k);
+    if(bPt){
+        SetBJetWeights(entry);
+        bNominal = bWeights[0];
 
-            if(weight != -999.) partWeight *= weight != 0 ? weight : 1.;
-            else break;
-        }   
+        partWeights[1 + 2*sf.size()] = nominal * bWeights[1];
+        partWeights[2 + 2*sf.size()] = nominal * bWeights[2];
     }
 
-    if(bWeight or bWeightUp or bWeightDown){
-        if(systIdx != -2) partWeight *= bWeight(entry);
-        else{
-            if(sysShift == "Up") partWeight *= bWeightUp(entry);
-            else partWeight *= bWeightDown(entry);
-        }
+    partWeights[0] = nominal * bNominal;
+
+    for(int idx = 0; idx < sf.size(); ++idx){
+        double others = sfPrefix[idx] * sfSuffix[idx + 1] * bNominal;
+
+        partWeights[1 + 2*idx] = others * sfProducts[idx][1];
+        partWeights[2 + 2*idx] = others * sfProducts[idx][2];
     }
 
-    return partWeight;
+    return partWeights;
+}
+
+double Weighter::GetPartWeight(const std::size_t& entry, const std::string& syst, const std::string& sysShift){
+    if(isData) return 1.;
+
+    return GetPartWeights(entry).at(GetWeightIndex(syst, sysShift));
 }
 
 double Weighter::GetTotalWeight(const std::size_t& entry, const std::string& syst, const std::string& sysShift){
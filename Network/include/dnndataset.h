@@ -14,6 +14,7 @@
 #include <ChargedAnalysis/Analysis/include/ntuplereader.h>
 #include <ChargedAnalysis/Analysis/include/decoder.h>
 #include <ChargedAnalysis/Utility/include/csv.h>
+#include <ChargedAnalysis/Utility/include/entryindex.h>
 
 /**
 * @brief Structure with pytorch Tensors of event kinematics for mass-parametrized DNN
@@ -38,7 +39,7 @@ class DNNDataSet{
         std::vector<std::string> parameters;
         torch::Device device;
 
-        std::vector<std::shared_ptr<NTupleReader>> readers;
+        std::shared_ptr<NTupleReader> reader;
         std::vector<NTupleFunction> functions;
 
         std::vector<std::size_t> chargedMasses, neutralMasses;
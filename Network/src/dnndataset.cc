@@ -17,23 +17,25 @@ DNNDataSet::DNNDataSet(const std::vector<std::string>& fileNames, const std::str
     chargedMasses(chargedMasses),
     neutralMasses(neutralMasses){
 
-    std::vector<std::shared_ptr<CSV>> idx(fileNames.size(), 0);
+    //Entry lists are either binary index files or CSV files with one index per row
+    std::vector<std::vector<long long>> idx(fileNames.size());
     std::vector<std::size_t> p(fileNames.size(), 0);
 
     for(std::size_t i = 0; i < fileNames.size(); ++i){
-        idx[i] = std::make_shared<CSV>(entryListName[i], "r", "\t");
+        if(EntryIndex::IsIndex(entryListName[i])) idx[i] = EntryIndex(entryListName[i]).GetEntries();
+        else idx[i] = CSV(entryListName[i], "r", "\t").GetColumn<long long>(0);
     }
 
     while(true){
         int nFin = 0;
 
         for(std::size_t i = 0; i < fileNames.size(); ++i){
-            if(p[i] >= idx[i]->GetNRows()){
+            if(p[i] >= idx[i].size()){
                 ++nFin;
                 continue;
             }
     
-            entryList.push_back({i, idx[i]->Get<int>(p[i], 0)});
+            entryList.push_back({i, idx[i][p[i]]});
             ++p[i];
         }
 
@@ -48,20 +50,21 @@ void DNNDataSet::Init(){
         //Open file/get tree (call this function in local thread)
         files.push_back(RUtil::Open(fileNames.at(i)));
         trees.push_back(RUtil::GetSmart<TTree>(files[i].get(), channel));
+    }
 
-        readers.push_back(std::make_shared<NTupleReader>(trees.back(), era));
-          
-        for(std::size_t p = 0; p < parameters.size(); ++p){
-            //Functor structure and arguments
-            NTupleFunction function = readers[i]->BuildFunc();
-            
-            //Read in everything, orders matter
-            parser.GetParticle(parameters.at(p), function);
-            parser.GetFunction(parameters.at(p), function);
-            function.Compile();
-
-            functions.push_back(function);
-        }
+    //One reader for all files, functions are only compiled once
+    reader = std::make_shared<NTupleReader>(trees, era);
+      
+    for(std::size_t p = 0; p < parameters.size(); ++p){
+        //Functor structure and arguments
+        NTupleFunction function = reader->BuildFunc();
+        
+        //Read in everything, orders matter
+        parser.GetParticle(parameters.at(p), function);
+        parser.GetFunction(parameters.at(p), function);
+        function.Compile();
+
+        functions.push_back(function);
     }
 }
 
@@ -93,11 +96,12 @@ DNNTensor DNNDataSet::Get(const std::size_t& entry){
     std::size_t fIdx, entr;
     std::tie(fIdx, entr) = entryList.at(entry);
 
-    readers.at(fIdx)->SetEntry(entr);
+    reader->SetTree(fIdx);
+    reader->SetEntry(entr);
     std::vector<float> paramValues(parameters.size());
 
     for(std::size_t idx = 0; idx < parameters.size(); ++idx){
-        paramValues.at(idx) = functions.at(fIdx*parameters.size() + idx).Get();
+        paramValues.at(idx) = functions.at(idx).Get();
         if(std::isnan(paramValues.at(idx))) paramValues.at(idx) = 0;
     }
 
@@ -0,0 +1,13 @@
+#include <ChargedAnalysis/Utility/include/parser.h>
+#include <ChargedAnalysis/Utility/include/entryindex.h>
+
+int main(int argc, char* argv[]){
+    //Extract informations of command line
+    Parser parser(argc, argv);
+
+    std::vector<std::string> inFiles = parser.GetVector<std::string>("input-files");
+    std::string outFile = parser.GetValue<std::string>("out-file");
+    std::vector<long long> offsets = parser.GetVector<long long, long long>("offsets", {});
+
+    EntryIndex::Merge(outFile, inFiles, offsets);
+}
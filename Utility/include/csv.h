@@ -2,13 +2,24 @@
 #define CSV_H
 
 #include <fstream>
+#include <sstream>
 #include <vector>
 #include <string_view>
 #include <map>
 #include <filesystem>
-#include <numeric>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <type_traits>
 #include <experimental/source_location>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <ChargedAnalysis/Utility/include/stringutil.h>
 #include <ChargedAnalysis/Utility/include/vectorutil.h>
 
@@ -17,26 +28,114 @@ class CSV{
         std::string mode;
         std::string delim;
         std::fstream file;
-        
-        std::vector<std::size_t> linePos;
-        std::vector<std::size_t> lineSize;
-        std::vector<std::string> colNames; 
-        
-        std::size_t lineMinBuff = 0, lineMaxBuff = 0;
-        std::vector<char> buffer;
 
-        std::filebuf* GetBuffer();
-        void WriteBuffer(std::filebuf* buffer);
+        //In read mode the file is memory mapped and each data line is a view into the mapping,
+        //rows appended in 'rw' mode are not visible for reading
+        int fileDescriptor = -1;
+        char* data = nullptr;
+        std::size_t size = 0;
+
+        std::vector<std::string_view> lines;
+        std::vector<std::string> colNames;
+        std::size_t nWritten = 0;
+
+        void Map(const std::string& fileName, const std::experimental::source_location& location);
+        void Unmap();
+
+        std::string_view GetBody();
+        void WriteBody(const std::string_view& body);
+
+        std::string_view GetField(const std::size_t& row, const std::size_t& column, const std::experimental::source_location& location){
+            std::string_view line = lines[row];
+
+            for(std::size_t col = 0; col < column; ++col){
+                std::size_t pos = line.find(delim);
+                if(pos == std::string_view::npos) throw std::runtime_error(StrUtil::PrettyError(location, "Line ", row, " has less than ", column + 1, " columns!"));
+
+                line.remove_prefix(pos + delim.size());
+            }
+
+            return line.substr(0, line.find(delim));
+        }
+
+        template<typename T>
+        static T Parse(std::string_view field, const std::experimental::source_location& location){
+            //Surrounding white spaces are ignored like in stream extraction
+            while(!field.empty() and std::isspace(field.front())) field.remove_prefix(1);
+            while(!field.empty() and std::isspace(field.back())) field.remove_suffix(1);
+
+            if constexpr(std::is_same_v<T, std::string>) return std::string(field);
+
+            else if constexpr(std::is_integral_v<T> and !std::is_same_v<T, bool>){
+                //The whole field has to be a number, not only a prefix like in '1.5' or '12abc'
+                T value{};
+                std::from_chars_result result = std::from_chars(field.data(), field.data() + field.size(), value);
+
+                if(result.ec != std::errc() or result.ptr != field.data() + field.size()){
+                    throw std::runtime_error(StrUtil::PrettyError(location, "Can not convert '", field, "' to a number!"));
+                }
+
+                return value;
+            }
+
+            else if constexpr(std::is_floating_point_v<T>){
+                T value{};
+
+                //Floating point std::from_chars is not available in older compilers
+#ifdef __cpp_lib_to_chars
+                std::from_chars_result result = std::from_chars(field.data(), field.data() + field.size(), value);
+                bool failed = result.ec != std::errc() or result.ptr != field.data() + field.size();
+#else
+                std::string copy(field);
+                char* end = nullptr;
+                value = std::strtod(copy.c_str(), &end);
+                bool failed = copy.empty() or *end != '\0';
+#endif
+
+                if(failed) throw std::runtime_error(StrUtil::PrettyError(location, "Can not convert '", field, "' to a number!"));
+
+                return value;
+            }
+
+            else{
+                T value{};
+                std::stringstream stream;
+                stream << field;
+                stream >> value;
+
+                return value;
+            }
+        }
+
+        std::size_t FindColumn(const std::string& columnName, const std::experimental::source_location& location){
+            try{
+                return VUtil::Find(colNames, columnName).at(0);
+            }
+            catch(std::out_of_range){
+                throw std::runtime_error(StrUtil::PrettyError(location, "Unknown column name '", columnName, "'!"));
+            }
+        }
+
+        void CheckRead(const std::experimental::source_location& location){
+            if(mode != "r" and mode != "rw"){
+                throw std::runtime_error(StrUtil::PrettyError(location, "Can not read in '", mode, "' filemode!"));
+            }
+        }
         
     public:
         CSV(const std::string& fileName, const std::string& fileMode, const std::string& delim = ",", const std::experimental::source_location& location = std::experimental::source_location::current());
         CSV(const std::string& fileName, const std::string& fileMode, const std::vector<std::string>& colNames, const std::string& delim = ",", const std::experimental::source_location& location = std::experimental::source_location::current());
         ~CSV(){Close();}
 
+        CSV(const CSV&) = delete;
+        CSV& operator=(const CSV&) = delete;
+
         std::size_t GetNColumns(){return colNames.size();}
-        std::size_t GetNRows(){return linePos.size();}
+        std::size_t GetNRows(){return lines.size() + nWritten;}
 
         bool Close(){
+            Unmap();
+
             if(file.is_open()){
                 file.close();
                 return true;
@@ -49,79 +148,62 @@ class CSV{
 
         template<typename T = std::string>
         std::vector<T> GetRow(const std::size_t& row, const std::experimental::source_location& location = std::experimental::source_location::current()){
-            if(mode != "r" and mode != "rw"){
-                throw std::runtime_error(StrUtil::PrettyError(location, "Can not read in '", mode, "' filemode!"));
-            }
-
-            if(row >= linePos.size()){
-                throw std::runtime_error(StrUtil::PrettyError(location, "Line number '", row, " too large with '", linePos.size() ,"'number of lines in file!"));
-            } 
-
-            if(row < lineMinBuff or lineMaxBuff < row or row == 0){
-                lineMinBuff = row;
-                lineMaxBuff = lineMinBuff + 1000;
+            CheckRead(location);
 
-                buffer.resize(std::accumulate(lineSize.begin() + lineMinBuff, lineMaxBuff < lineSize.size() ? lineSize.begin() + lineMaxBuff : lineSize.end(),  0));
-
-                file.clear();
-                file.seekg(linePos.at(row));
-                file.read(buffer.data(), buffer.size());
+            if(row >= lines.size()){
+                throw std::runtime_error(StrUtil::PrettyError(location, "Line number '", row, " too large with '", lines.size() ,"'number of lines in file!"));
             }
 
-            std::string_view line(buffer.data() + std::accumulate(lineSize.begin() + lineMinBuff, lineSize.begin() + row, 0), lineSize.at(row) - 1);
+            std::vector<T> out;
+            out.reserve(colNames.size());
 
-            //If more than one column, split by delimeter and return
-            if(colNames.size() > 1){
-                return StrUtil::Split<T>(std::string(line.data()), delim);
-            }
+            std::string_view line = lines[row];
 
-            //If only one column, no need for splitting
-            else{
-                T out;
-                std::stringstream rowStream;
-                rowStream << line;
-                rowStream >> out;
+            while(true){
+                std::size_t pos = line.find(delim);
+                out.push_back(Parse<T>(line.substr(0, pos), location));
 
-                return {out};
+                if(pos == std::string_view::npos) break;
+                line.remove_prefix(pos + delim.size());
             }
+
+            return out;
         }
         
         template<typename T = std::string>
         T Get(const std::size_t& row, const std::size_t& column, const std::experimental::source_location& location = std::experimental::source_location::current()){
+            CheckRead(location);
+
             if(column >= colNames.size()){
                 throw std::runtime_error(StrUtil::PrettyError(location, "Column number '", column, " too large with '", colNames.size() ,"'number of columns in file!"));
             }
 
-            return GetRow<T>(row, location).at(column);
+            if(row >= lines.size()){
+                throw std::runtime_error(StrUtil::PrettyError(location, "Line number '", row, " too large with '", lines.size() ,"'number of lines in file!"));
+            }
+
+            return Parse<T>(GetField(row, column, location), location);
         }
         
         template<typename T = std::string>
         T Get(const std::size_t& row, const std::string& columnName, const std::experimental::source_location& location = std::experimental::source_location::current()){
-            std::size_t column;
-        
-            //Try to find column number
-            try{
-                column = VUtil::Find(colNames, columnName).at(0);
-            }
-            catch(std::out_of_range){
-                throw std::runtime_error(StrUtil::PrettyError(location, "Unknown column name '", columnName, "'!"));
-            }
-            
-            //Call get function with row/column number
-            return Get<T>(row, column, location);
+            return Get<T>(row, FindColumn(columnName, location), location);
         }
 
         template<typename T = std::string>
         std::vector<T> GetColumn(const std::size_t& column, const std::experimental::source_location& location = std::experimental::source_location::current()){
-            if(StrUtil::Find(mode, "r").empty()){
-                throw std::runtime_error(StrUtil::PrettyError(location, "Can not read in '", mode, "' filemode!"));
+            CheckRead(location);
+
+            if(column >= colNames.size()){
+                throw std::runtime_error(StrUtil::PrettyError(location, "Column number '", column, " too large with '", colNames.size() ,"'number of columns in file!"));
             }
 
             std::vector<T> out;
+            out.reserve(lines.size());
             
-            //Read out all rows and extract column info
-            for(int i = 0; i < linePos.size(); ++i){
-                out.push_back(Get<T>(i, column, location));
+            //Single pass over all lines of the mapped file
+            for(std::size_t row = 0; row < lines.size(); ++row){
+                out.push_back(Parse<T>(GetField(row, column, location), location));
             } 
 
             return out;
@@ -129,17 +211,7 @@ class CSV{
 
         template<typename T = std::string>
         std::vector<T> GetColumn(const std::string& columnName, const std::experimental::source_location& location = std::experimental::source_location::current()){
-            std::size_t column;
-        
-            //Try to find column number
-            try{
-                column = VUtil::Find(colNames, columnName).at(0);
-            }
-            catch(std::out_of_range){
-                throw std::runtime_error(StrUtil::PrettyError(location, "Unknown column name '", columnName, "'!"));
-            }
-
-            return GetColumn<T>(column, location);
+            return GetColumn<T>(FindColumn(columnName, location), location);
         }
 
         template <typename... T>
@@ -158,7 +230,7 @@ class CSV{
             file << result;
 
             //Update file information
-            linePos.push_back(linePos.back() + result.size());
+            ++nWritten;
         }
 };
 
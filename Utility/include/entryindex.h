@@ -0,0 +1,148 @@
+#ifndef ENTRYINDEX_H
+#define ENTRYINDEX_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+#include <iterator>
+#include <algorithm>
+#include <functional>
+#include <experimental/source_location>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <ChargedAnalysis/Utility/include/stringutil.h>
+
+/**
+* @brief Compact binary list of sorted tree entries, e.g. the passing entries of a region
+*
+* The file starts with a header (magic, version, input file, tree and region name, number of entries),
+* followed by the differences of consecutive entries encoded as unsigned LEB128 varints.
+* The file is memory mapped for reading and decoded while iterating.
+*
+* Example:
+* @code
+* EntryIndex::Write("index.idx", {"file.root", "Muon", "Default"}, {1, 5, 42});
+*
+* EntryIndex index("index.idx");
+* for(const long long& entry : index) std::cout << entry << std::endl;
+* @endcode
+*/
+
+class EntryIndex{
+    public:
+        struct Header{
+            std::string file, tree, region;
+            std::uint64_t nEntries = 0;
+        };
+
+        /**
+        * @brief Forward iterator decoding the entries on the fly
+        */
+        class Iterator{
+            private:
+                const unsigned char* pos;
+                const unsigned char* end;
+                std::uint64_t remaining;
+                long long entry = 0;
+
+                void Decode();
+
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = long long;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const long long*;
+                using reference = const long long&;
+
+                Iterator(const unsigned char* pos, const unsigned char* end, const std::uint64_t& remaining) : pos(pos), end(end), remaining(remaining){Decode();}
+
+                const long long& operator*() const {return entry;}
+                Iterator& operator++(){--remaining; Decode(); return *this;}
+                bool operator==(const Iterator& other) const {return remaining == other.remaining;}
+                bool operator!=(const Iterator& other) const {return remaining != other.remaining;}
+        };
+
+    private:
+        static constexpr std::uint32_t version = 1;
+
+        Header header;
+        int fileDescriptor = -1;
+        unsigned char* data = nullptr;
+        std::size_t size = 0;
+        const unsigned char* payload = nullptr;
+
+        void Release();
+
+        static std::string ReadString(const unsigned char*& pos, const unsigned char* end, const std::string& fileName, const std::experimental::source_location& location);
+        static std::uint64_t ReadValue(const unsigned char*& pos, const unsigned char* end, const std::string& fileName, const std::experimental::source_location& location);
+
+    public:
+        /**
+        * @brief Memory map an index file and read its header
+        *
+        * @param fileName Name of the index file
+        * @param location Standard library object containing the file positions
+        */
+        EntryIndex(const std::string& fileName, const std::experimental::source_location& location = std::experimental::source_location::current());
+        ~EntryIndex();
+
+        EntryIndex(const EntryIndex&) = delete;
+        EntryIndex& operator=(const EntryIndex&) = delete;
+
+        const Header& GetHeader() const {return header;}
+        std::uint64_t GetN() const {return header.nEntries;}
+
+        Iterator begin() const {return Iterator(payload, data + size, header.nEntries);}
+        Iterator end() const {return Iterator(nullptr, nullptr, 0);}
+
+        /**
+        * @brief Decode all entries at once
+        *
+        * @return Sorted vector of entries
+        */
+        std::vector<long long> GetEntries() const;
+
+        /**
+        * @brief Check if file starts with the magic of an index file
+        *
+        * @param fileName Name of the file to check
+        * @return True if file is an index file
+        */
+        static bool IsIndex(const std::string& fileName);
+
+        /**
+        * @brief Check if file name has the extension of index files (.idx)
+        *
+        * @param fileName Name of the file to check
+        * @return True if file name ends with .idx
+        */
+        static bool IsIndexName(const std::string& fileName){return fileName.size() >= 4 and fileName.compare(fileName.size() - 4, 4, ".idx") == 0;}
+
+        /**
+        * @brief Write sorted entries to an index file
+        *
+        * @param fileName Name of the output file
+        * @param header Header information, the number of entries is set from the entries
+        * @param entries Sorted entries
+        * @param location Standard library object containing the file positions
+        */
+        static void Write(const std::string& fileName, Header header, const std::vector<long long>& entries, const std::experimental::source_location& location = std::experimental::source_location::current());
+
+        /**
+        * @brief Merge index files, the offset of each input file is added to its entries
+        *
+        * @param outFile Name of the output file
+        * @param inputFiles Names of the input files
+        * @param offsets Offset for each input file, e.g. position of the file in a merged tree, zero if empty
+        * @param location Standard library object containing the file positions
+        */
+        static void Merge(const std::string& outFile, const std::vector<std::string>& inputFiles, const std::vector<long long>& offsets = {}, const std::experimental::source_location& location = std::experimental::source_location::current());
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include <Math/GenVector/PxPyPzE4D.h>
 
 #include <ChargedAnalysis/Utility/include/vectorutil.h>
+#include <ChargedAnalysis/Utility/include/mathutil.h>
 #include <ChargedAnalysis/Analysis/include/ntuplereader.h>
 #include <ChargedAnalysis/Analysis/include/decoder.h>
 #include <ChargedAnalysis/Utility/include/csv.h>
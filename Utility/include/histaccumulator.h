@@ -0,0 +1,129 @@
+/**
+* @file histaccumulator.h
+* @brief Header file for HistAxis and HistAccumulator class
+*/
+
+#ifndef HISTACCUMULATOR_H
+#define HISTACCUMULATOR_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include <TH1.h>
+#include <TAxis.h>
+
+/**
+* @brief Copy of TAxis binning with bin search without virtual calls
+*
+* Bin numbering follows the ROOT convention, 0 is the underflow and nBins + 1 the overflow bin.
+*/
+
+class HistAxis{
+    private:
+        int nBins = 0;
+        double low = 0., high = 1.;
+        std::vector<double> edges;
+
+    public:
+        HistAxis(){}
+
+        /**
+        * @brief Constructor copying the binning of a ROOT axis
+        *
+        * @param axis Axis of booked histogram
+        */
+        HistAxis(const TAxis* axis) :
+            nBins(axis->GetNbins()),
+            low(axis->GetXmin()),
+            high(axis->GetXmax()){
+                if(axis->GetXbins()->GetSize() != 0) edges = std::vector<double>(axis->GetXbins()->GetArray(), axis->GetXbins()->GetArray() + nBins + 1);
+        }
+
+        int GetNBins() const {return nBins;}
+
+        /**
+        * @brief Find bin of value, O(1) for uniform binning and binary search for variable binning
+        *
+        * @param x Value to find the bin for
+        * @return Bin number
+        */
+        int FindBin(const float& x) const {
+            if(x < low) return 0;
+            if(!(x < high)) return nBins + 1;
+
+            if(edges.empty()) return 1 + int(nBins*(x - low)/(high - low));
+            else return std::upper_bound(edges.begin(), edges.end(), x) - edges.begin();
+        }
+};
+
+/**
+* @brief Dense sum of weights and squared weights, which is added to a ROOT histogram at the end
+*
+* Example:
+* @code
+* HistAxis axis(hist->GetXaxis());
+* HistAccumulator acc(hist);
+*
+* acc.Fill(axis.FindBin(x), w);
+* acc.Flush(hist);
+* @endcode
+*/
+
+class HistAccumulator{
+    private:
+        std::vector<double> sumw, sumw2;
+        double entries = 0.;
+
+    public:
+        HistAccumulator(){}
+
+        /**
+        * @brief Constructor with bins of booked histogram including under/overflow bins
+        *
+        * @param hist Booked histogram
+        */
+        HistAccumulator(const TH1* hist) : sumw(hist->GetNcells(), 0.), sumw2(hist->GetNcells(), 0.){}
+
+        /**
+        * @brief Global bin number of 2D histogram as given by TH1::GetBin
+        *
+        * @param xAxis Axis in x direction
+        * @param binX Bin in x direction
+        * @param binY Bin in y direction
+        * @return Global bin number
+        */
+        static int GetBin(const HistAxis& xAxis, const int& binX, const int& binY){
+            return binX + (xAxis.GetNBins() + 2)*binY;
+        }
+
+        void Fill(const int& bin, const double& weight){
+            sumw[bin] += weight;
+            sumw2[bin] += weight*weight;
+            ++entries;
+        }
+
+        /**
+        * @brief Add accumulated content to histogram and reset accumulator
+        *
+        * @param hist Histogram with the same binning as used for the accumulator
+        */
+        void Flush(TH1* hist){
+            double nEntries = hist->GetEntries() + entries;
+
+            for(int bin = 0; bin < sumw.size(); ++bin){
+                if(sumw2[bin] == 0.) continue;
+
+                hist->SetBinContent(bin, hist->GetBinContent(bin) + sumw[bin]);
+                hist->SetBinError(bin, std::sqrt(std::pow(hist->GetBinError(bin), 2) + sumw2[bin]));
+            }
+
+            hist->SetEntries(nEntries);
+
+            std::fill(sumw.begin(), sumw.end(), 0.);
+            std::fill(sumw2.begin(), sumw2.end(), 0.);
+            entries = 0.;
+        }
+};
+
+#endif
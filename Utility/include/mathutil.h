@@ -3,12 +3,22 @@
 
 #include <cmath>
 #include <vector>
+#include <array>
 
 /**
 * @brief Math utility library to for calculating properties
 */
 
 namespace MUtil{
+    /**
+    * @brief Calculates @f$\Delta\phi @f$ between to particles, wrapped into [0, @f$\pi @f$]
+    *
+    * @param phi1 Phi value of first particle
+    * @param phi2 Phi value of second particle
+    * @return Return @f$\Delta\phi @f$
+    */
+    float DeltaPhi(const float& phi1, const float& phi2);
+
     /**
     * @brief Calculates @f$\Delta @f$R between to particles
     *
@@ -21,13 +31,54 @@ namespace MUtil{
     float DeltaR(const float& eta1, const float& phi1, const float& eta2, const float& phi2);
 
     /**
-    * @brief Calculates @f$\Delta\phi @f$ between to particles
+    * @brief Calculates invariant mass of two particles without building Lorentz vectors
     *
+    * @param pt1 Pt value of first particle
+    * @param eta1 Eta value of first particle
     * @param phi1 Phi value of first particle
+    * @param m1 Mass of first particle
+    * @param pt2 Pt value of second particle
+    * @param eta2 Eta value of second particle
     * @param phi2 Phi value of second particle
-    * @return Return @f$\Delta\phi @f$
+    * @param m2 Mass of second particle
+    * @return Return invariant mass
     */
-    float DeltaPhi(const float& phi1, const float& phi2);
+    float InvMass(const float& pt1, const float& eta1, const float& phi1, const float& m1, const float& pt2, const float& eta2, const float& phi2, const float& m2);
+
+    /**
+    * @brief Calculates transverse mass of two massless particles
+    *
+    * @param pt1 Pt value of first particle
+    * @param phi1 Phi value of first particle
+    * @param pt2 Pt value of second particle
+    * @param phi2 Phi value of second particle
+    * @return Return transverse mass
+    */
+    float TransverseMass(const float& pt1, const float& phi1, const float& pt2, const float& phi2);
+
+    /**
+    * @brief Calculates lepton projection variable L_{P} of lepton and missing transverse energy
+    *
+    * @param ptL Pt value of lepton
+    * @param phiL Phi value of lepton
+    * @param ptMet Pt value of missing transverse energy
+    * @param phiMet Phi value of missing transverse energy
+    * @return Return L_{P}
+    */
+    float LP(const float& ptL, const float& phiL, const float& ptMet, const float& phiMet);
+
+    /**
+    * @brief Calculates pt, eta and phi of the sum of two massless particles
+    *
+    * @param pt1 Pt value of first particle
+    * @param eta1 Eta value of first particle
+    * @param phi1 Phi value of first particle
+    * @param pt2 Pt value of second particle
+    * @param eta2 Eta value of second particle
+    * @param phi2 Phi value of second particle
+    * @return Return array with {pt, eta, phi}
+    */
+    std::array<float, 3> Sum(const float& pt1, const float& eta1, const float& phi1, const float& pt2, const float& eta2, const float& phi2);
 
     int RowMajIdx(const std::vector<int>& dimensions, const std::vector<int>& indeces);
 };
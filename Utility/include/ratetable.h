@@ -0,0 +1,67 @@
+/**
+* @file ratetable.h
+* @brief Header file for RateTable class
+*/
+
+#ifndef RATETABLE_H
+#define RATETABLE_H
+
+#include <vector>
+
+#include <TH2.h>
+
+#include <ChargedAnalysis/Utility/include/histaccumulator.h>
+
+/**
+* @brief Flat copy of 2D rate/efficiency histogram for fast lookups in the event loop
+*
+* Example:
+* @code
+* RateTable fakeRate(hist);
+* fakeRate.FillEmpty(79.9);
+*
+* float rate = fakeRate.Get(pt, eta);
+* @endcode
+*/
+
+class RateTable{
+    private:
+        HistAxis xAxis, yAxis;
+        std::vector<float> contents;
+
+    public:
+        RateTable(){}
+
+        /**
+        * @brief Constructor copying binning and bin contents including under/overflow bins
+        *
+        * @param hist Histogram with rates
+        */
+        RateTable(const TH2* hist) : xAxis(hist->GetXaxis()), yAxis(hist->GetYaxis()){
+            for(int bin = 0; bin < hist->GetNcells(); ++bin) contents.push_back(hist->GetBinContent(bin));
+        }
+
+        /**
+        * @brief Replace empty bins with the content of the bin at x value in the same y row
+        *
+        * @param x Value in x direction to take the content from, e.g. the last filled bin
+        */
+        void FillEmpty(const float& x){
+            int fallbackX = xAxis.FindBin(x);
+
+            for(int binY = 0; binY < yAxis.GetNBins() + 2; ++binY){
+                for(int binX = 0; binX < xAxis.GetNBins() + 2; ++binX){
+                    float& content = contents[HistAccumulator::GetBin(xAxis, binX, binY)];
+                    if(content == 0) content = contents[HistAccumulator::GetBin(xAxis, fallbackX, binY)];
+                }
+            }
+        }
+
+        float Get(const float& x, const float& y) const {
+            return contents[HistAccumulator::GetBin(xAxis, xAxis.FindBin(x), yAxis.FindBin(y))];
+        }
+
+        explicit operator bool() const {return !contents.empty();}
+};
+
+#endif
@@ -9,6 +9,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <algorithm>
 #include <experimental/source_location>
 
 #include <ChargedAnalysis/Utility/include/stringutil.h>
@@ -51,6 +52,53 @@ namespace RUtil{
 
     int GetLen(TLeaf* leaf, const int& entry);
 
+    /**
+    * @brief Split entry range of TTree in sub ranges aligned to the basket clusters
+    *
+    * Example:
+    * @code
+    * std::vector<std::pair<long long, long long>> ranges = RUtil::SplitByCluster(myTree, 0, 100000, 4);
+    * @endcode
+    *
+    * @param tree TTree to split
+    * @param entryStart First entry of the range
+    * @param entryEnd Last entry of the range (exclusive)
+    * @param nRanges Wished number of ranges, less are returned if the tree has not enough clusters
+    * @return Vector with pairs of [start, end) of each range
+    */
+    std::vector<std::pair<long long, long long>> SplitByCluster(TTree* tree, const long long& entryStart, const long long& entryEnd, const int& nRanges);
+
+    /**
+    * @brief Get start entries of all basket clusters of a TTree
+    *
+    * Example:
+    * @code
+    * std::vector<long long> boundaries = RUtil::ClusterBoundaries(myTree);
+    * @endcode
+    *
+    * @param tree TTree to inspect
+    * @return Start entry of each cluster, the last element is the number of entries of the tree
+    */
+    std::vector<long long> ClusterBoundaries(TTree* tree);
+
+    /**
+    * @brief Split whole TTree in ranges of consecutive clusters with a target size
+    *
+    * Clusters are added to a range until it has at least the wished number of events or bytes.
+    * The byte size uses the average compressed size per entry of the tree.
+    *
+    * Example:
+    * @code
+    * std::vector<std::pair<long long, long long>> ranges = RUtil::SplitByClusterSize(myTree, 500000, 0);
+    * @endcode
+    *
+    * @param tree TTree to split
+    * @param nEvents Target number of events per range, ignored if zero
+    * @param nBytes Target number of compressed bytes per range, ignored if zero
+    * @return Vector with pairs of [start, end) of each range
+    */
+    std::vector<std::pair<long long, long long>> SplitByClusterSize(TTree* tree, const long long& nEvents, const long long& nBytes);
+
     /**
     * @brief Get object from TFile with exception handling
     *
@@ -31,33 +31,44 @@ CSV::CSV(const std::string& fileName, const std::string& fileMode, const std::ve
         if(!std::filesystem::exists(dir)) std::filesystem::create_directories(dir);
     }
 
-    //Open file
-    file.open(fileName, modes[fileMode]);
-    
-    if(!file.is_open()){
-        throw std::runtime_error(StrUtil::PrettyError(location, "Could not open file: '", fileName, "'!"));
+    //Read mode only needs the memory mapped file, the stream is used for writing
+    if(fileMode != "r"){
+        file.open(fileName, modes[fileMode]);
+        
+        if(!file.is_open()){
+            throw std::runtime_error(StrUtil::PrettyError(location, "Could not open file: '", fileName, "'!"));
+        }
     }
     
-    //Save in read mode for each line length of line for later read out
+    //Build index of all lines in one pass over the mapped file
     if(fileMode == "r" or fileMode == "rw"){
-        std::string line;
-        
-        //Read out header (which is assumed to exist)
-        std::getline(file, line);
-        if(line.size() == 0) throw std::runtime_error(StrUtil::PrettyError(location, "File is empty: '", fileName, "'!"));
+        Map(fileName, location);
 
-        this->colNames = StrUtil::Split(line, delim);
-        if(this->colNames.size() == 1) this->colNames = {line};
-        
-        linePos.push_back(line.size() + 1);
-        
-        //Read line lenghts for data in file
-        while (std::getline(file, line)){
-            linePos.push_back(line.size() + linePos.back() + 1);
-            lineSize.push_back(line.size() + 1);
+        const char* pos = data;
+        const char* end = data + size;
+
+        while(pos < end){
+            const char* lineEnd = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+            if(lineEnd == nullptr) lineEnd = end;
+
+            std::string_view line(pos, lineEnd - pos);
+            if(!line.empty() and line.back() == '\r') line.remove_suffix(1);
+
+            lines.push_back(line);
+            pos = lineEnd + 1;
         }
-        
-        linePos.pop_back();
+
+        //Read out header (which is assumed to exist)
+        if(lines.empty() or lines.front().empty()){
+            Unmap();
+            throw std::runtime_error(StrUtil::PrettyError(location, "File is empty: '", fileName, "'!"));
+        }
+
+        std::string header(lines.front());
+        this->colNames = StrUtil::Split(header, delim);
+        if(this->colNames.size() == 1) this->colNames = {header};
+
+        lines.erase(lines.begin());
     }
 
     //Write header in write mode
@@ -67,37 +78,74 @@ CSV::CSV(const std::string& fileName, const std::string& fileMode, const std::ve
         if(colNames.empty()){
             throw std::runtime_error(StrUtil::PrettyError(location, "No column names for write mode are given!"));
         }
-        
-        std::size_t lineSize = 0;
+
 
         for(const std::string name : VUtil::Slice(colNames, 0, -1)){
             file << name << delim;
-            lineSize += name.size() + delim.size();
         }
         
         file << colNames.back() << std::endl;
-        linePos.push_back(lineSize + colNames.back().size() + 1);
     }
 }
 
-std::filebuf* CSV::GetBuffer(){
-    //Get buffer without header
-    file.clear();
-   
-    if(linePos.size() > 0){
-        file.seekg(linePos.at(0));
+void CSV::Map(const std::string& fileName, const std::experimental::source_location& location){
+    fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if(fileDescriptor < 0) throw std::runtime_error(StrUtil::PrettyError(location, "Could not open file: '", fileName, "'!"));
+
+    //The object is not fully constructed yet, so the descriptor is closed here before throwing
+    struct stat info;
+
+    if(fstat(fileDescriptor, &info) != 0){
+        Unmap();
+        throw std::runtime_error(StrUtil::PrettyError(location, "Could not get size of file: '", fileName, "'!"));
+    }
+
+    size = info.st_size;
 
-        return file.rdbuf();
+    if(size == 0){
+        Unmap();
+        throw std::runtime_error(StrUtil::PrettyError(location, "File is empty: '", fileName, "'!"));
     }
 
-    else return nullptr;
+    void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+
+    if(mapped == MAP_FAILED){
+        Unmap();
+        throw std::runtime_error(StrUtil::PrettyError(location, "Could not memory map file: '", fileName, "'!"));
+    }
+
+    data = static_cast<char*>(mapped);
+    madvise(data, size, MADV_SEQUENTIAL);
 }
 
-void CSV::WriteBuffer(std::filebuf* buffer){
-    if(buffer != nullptr){
+void CSV::Unmap(){
+    lines.clear();
+
+    if(data != nullptr) munmap(data, size);
+    if(fileDescriptor >= 0) close(fileDescriptor);
+
+    data = nullptr;
+    size = 0;
+    fileDescriptor = -1;
+}
+
+std::string_view CSV::GetBody(){
+    //Get content without header
+    if(data == nullptr) return {};
+
+    const char* headerEnd = static_cast<const char*>(std::memchr(data, '\n', size));
+    if(headerEnd == nullptr) return {};
+
+    return std::string_view(headerEnd + 1, data + size - headerEnd - 1);
+}
+
+void CSV::WriteBody(const std::string_view& body){
+    if(!body.empty()){
         file.clear();
         file.seekp(0, std::ios::end);
-        file << buffer;
+        file.write(body.data(), body.size());
+
+        nWritten += std::count(body.begin(), body.end(), '\n');
     }
 }
 
@@ -129,7 +177,7 @@ void CSV::Merge(const std::string& outFile, const std::vector<std::string>& inpu
         std::cout << inputFiles.at(idx) << std::endl;
 
         CSV toMerge(inputFiles.at(idx), "r", delim);
-        out.WriteBuffer(toMerge.GetBuffer());
+        out.WriteBody(toMerge.GetBody());
     }
 
     return;
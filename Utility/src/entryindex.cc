@@ -0,0 +1,191 @@
+#include <ChargedAnalysis/Utility/include/entryindex.h>
+
+void EntryIndex::Iterator::Decode(){
+    if(remaining == 0) return;
+
+    //Unsigned LEB128, seven bits per byte with the high bit marking a following byte
+    std::uint64_t delta = 0;
+    int shift = 0;
+
+    while(true){
+        if(pos == end or shift >= 64) throw std::runtime_error(StrUtil::PrettyError(std::experimental::source_location::current(), "Corrupt index file, entry ", entry, " is not followed by a valid varint!"));
+
+        unsigned char byte = *pos++;
+        delta |= std::uint64_t(byte & 0x7f) << shift;
+
+        if(!(byte & 0x80)) break;
+        shift += 7;
+    }
+
+    entry += delta;
+}
+
+EntryIndex::EntryIndex(const std::string& fileName, const std::experimental::source_location& location){
+    fileDescriptor = open(fileName.c_str(), O_RDONLY);
+    if(fileDescriptor < 0) throw std::runtime_error(StrUtil::PrettyError(location, "Could not open index file '", fileName, "'!"));
+
+    //The destructor does not run if the constructor throws, so release mapping and descriptor here
+    try{
+        struct stat info;
+        if(fstat(fileDescriptor, &info) != 0) throw std::runtime_error(StrUtil::PrettyError(location, "Could not get size of index file '", fileName, "'!"));
+
+        size = info.st_size;
+        if(size == 0) throw std::runtime_error(StrUtil::PrettyError(location, "Index file '", fileName, "' is empty!"));
+
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if(mapped == MAP_FAILED) throw std::runtime_error(StrUtil::PrettyError(location, "Could not memory map index file '", fileName, "'!"));
+
+        data = static_cast<unsigned char*>(mapped);
+        madvise(data, size, MADV_SEQUENTIAL);
+
+        const unsigned char* pos = data;
+        const unsigned char* end = data + size;
+
+        if(size < 10 or std::string(reinterpret_cast<const char*>(pos), 6) != "CHINDX") throw std::runtime_error(StrUtil::PrettyError(location, "File '", fileName, "' is no index file!"));
+        pos += 6;
+
+        std::uint32_t fileVersion;
+        std::copy(pos, pos + sizeof(fileVersion), reinterpret_cast<unsigned char*>(&fileVersion));
+        pos += sizeof(fileVersion);
+
+        if(fileVersion != version) throw std::runtime_error(StrUtil::PrettyError(location, "Index file '", fileName, "' has version ", fileVersion, " instead of ", version, "!"));
+
+        header.file = ReadString(pos, end, fileName, location);
+        header.tree = ReadString(pos, end, fileName, location);
+        header.region = ReadString(pos, end, fileName, location);
+        header.nEntries = ReadValue(pos, end, fileName, location);
+
+        std::uint64_t nBytes = ReadValue(pos, end, fileName, location);
+        if(std::uint64_t(end - pos) != nBytes) throw std::runtime_error(StrUtil::PrettyError(location, "Index file '", fileName, "' is truncated!"));
+
+        //Each entry is encoded in at least one byte
+        if(header.nEntries > nBytes) throw std::runtime_error(StrUtil::PrettyError(location, "Index file '", fileName, "' claims ", header.nEntries, " entries in ", nBytes, " bytes!"));
+
+        payload = pos;
+    }
+
+    catch(...){
+        Release();
+        throw;
+    }
+}
+
+EntryIndex::~EntryIndex(){
+    Release();
+}
+
+void EntryIndex::Release(){
+    if(data != nullptr) munmap(data, size);
+    if(fileDescriptor >= 0) close(fileDescriptor);
+
+    data = nullptr;
+    fileDescriptor = -1;
+}
+
+std::string EntryIndex::ReadString(const unsigned char*& pos, const unsigned char* end, const std::string& fileName, const std::experimental::source_location& location){
+    std::uint64_t length = ReadValue(pos, end, fileName, location);
+    if(std::uint64_t(end - pos) < length) throw std::runtime_error(StrUtil::PrettyError(location, "Index file '", fileName, "' is truncated!"));
+
+    std::string value(reinterpret_cast<const char*>(pos), length);
+    pos += length;
+
+    return value;
+}
+
+std::uint64_t EntryIndex::ReadValue(const unsigned char*& pos, const unsigned char* end, const std::string& fileName, const std::experimental::source_location& location){
+    std::uint64_t value;
+    if(std::size_t(end - pos) < sizeof(value)) throw std::runtime_error(StrUtil::PrettyError(location, "Index file '", fileName, "' is truncated!"));
+
+    std::copy(pos, pos + sizeof(value), reinterpret_cast<unsigned char*>(&value));
+    pos += sizeof(value);
+
+    return value;
+}
+
+std::vector<long long> EntryIndex::GetEntries() const {
+    std::vector<long long> entries;
+    entries.reserve(header.nEntries);
+
+    for(const long long& entry : *this) entries.push_back(entry);
+
+    return entries;
+}
+
+bool EntryIndex::IsIndex(const std::string& fileName){
+    std::ifstream file(fileName, std::ios::binary);
+    char magic[6];
+
+    if(!file.read(magic, 6)) return false;
+
+    return std::string(magic, 6) == "CHINDX";
+}
+
+void EntryIndex::Write(const std::string& fileName, Header header, const std::vector<long long>& entries, const std::experimental::source_location& location){
+    //Encode differences of consecutive entries, which are small for dense selections
+    std::vector<unsigned char> encoded;
+    encoded.reserve(entries.size());
+    long long previous = 0;
+
+    for(const long long& entry : entries){
+        if(entry < previous) throw std::runtime_error(StrUtil::PrettyError(location, "Entries for index file '", fileName, "' are not sorted!"));
+
+        std::uint64_t delta = entry - previous;
+        previous = entry;
+
+        do{
+            unsigned char byte = delta & 0x7f;
+            delta >>= 7;
+
+            encoded.push_back(delta != 0 ? byte | 0x80 : byte);
+        } while(delta != 0);
+    }
+
+    header.nEntries = entries.size();
+
+    //Create directory if not already there
+    std::filesystem::path dir = std::filesystem::path(fileName).parent_path();
+    if(!dir.empty() and !std::filesystem::exists(dir)) std::filesystem::create_directories(dir);
+
+    std::ofstream out(fileName, std::ios::binary);
+    if(!out) throw std::runtime_error(StrUtil::PrettyError(location, "Could not open index file '", fileName, "' for writing!"));
+
+    std::function<void(const std::uint64_t&)> writeValue = [&](const std::uint64_t& value){out.write(reinterpret_cast<const char*>(&value), sizeof(value));};
+    std::function<void(const std::string&)> writeString = [&](const std::string& value){writeValue(value.size()); out.write(value.data(), value.size());};
+
+    out.write("CHINDX", 6);
+    out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+
+    writeString(header.file);
+    writeString(header.tree);
+    writeString(header.region);
+    writeValue(header.nEntries);
+    writeValue(encoded.size());
+
+    out.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    out.close();
+
+    if(!out) throw std::runtime_error(StrUtil::PrettyError(location, "Could not write index file '", fileName, "'!"));
+}
+
+void EntryIndex::Merge(const std::string& outFile, const std::vector<std::string>& inputFiles, const std::vector<long long>& offsets, const std::experimental::source_location& location){
+    if(inputFiles.empty()) throw std::runtime_error(StrUtil::PrettyError(location, "Empty list of input files is given!"));
+    if(!offsets.empty() and offsets.size() != inputFiles.size()) throw std::runtime_error(StrUtil::PrettyError(location, "Number of offsets (", offsets.size(), ") does not match number of input files (", inputFiles.size(), ")!"));
+
+    Header header;
+    std::vector<long long> entries;
+
+    for(std::size_t idx = 0; idx < inputFiles.size(); ++idx){
+        EntryIndex index(inputFiles.at(idx));
+        long long offset = offsets.empty() ? 0 : offsets.at(idx);
+
+        if(idx == 0) header = index.GetHeader();
+
+        for(const long long& entry : index) entries.push_back(entry + offset);
+    }
+
+    //Inputs of consecutive job ranges are already in order, sorting only matters for arbitrary offsets
+    if(!std::is_sorted(entries.begin(), entries.end())) std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    Write(outFile, header, entries);
+}
@@ -274,7 +274,6 @@ std::map<std::string, std::vector<float>> Extension::DNNScore(std::shared_ptr<TT
 std::map<std::string, std::vector<float>> Extension::HReconstruction(std::shared_ptr<TTree>& tree, const int& entryStart, const int& entryEnd, const int& era){
     typedef ROOT::Math::LorentzVector<ROOT::Math::PtEtaPhiM4D<double>> PolarLV;
     typedef ROOT::Math::LorentzVector<ROOT::Math::PxPyPzE4D<double>> CartLV;
-    typedef std::vector<std::pair<PolarLV, PolarLV>> hCandVec;
 
     //Set values with default values
     std::map<std::string, std::vector<float>> values;
@@ -340,66 +339,75 @@ std::map<std::string, std::vector<float>> Extension::HReconstruction(std::shared
         }
 
         //Intermediate step to save all possible combinations of two jets from jet collection
+        //and their invariant mass
         std::vector<std::pair<int, int>> combi;
+        std::vector<float> pairMass;
         
         for(unsigned int k = 0; k < jets.size(); k++){
             for(unsigned int j = 0; j < k; j++){
                 combi.push_back({k, j});
+                pairMass.push_back(MUtil::InvMass(jets[k].Pt(), jets[k].Eta(), jets[k].Phi(), jets[k].M(), jets[j].Pt(), jets[j].Eta(), jets[j].Phi(), jets[j].M()));
             }
         }
 
-        //Vector of candPairs
-        hCandVec hCands; 
+        //Best candidate pair with smallest mass diff of jet pairs
+        std::pair<PolarLV, PolarLV> hCand;
+        float minDiff = std::numeric_limits<float>::max();
     
         //If 4 jets and no fat jets
         if(jets.size() >= 4){
-            //Construct all pairs of possible jet pairs
+            //Check all pairs of possible jet pairs
+            std::pair<int, int> best;
+
             for(unsigned int k = 0; k < combi.size(); ++k){
                 for(unsigned int j = 0; j < k; ++j){
                     //Check if not same jet in both pair
                     std::set<int> check = {combi[k].first, combi[k].second, combi[j].first, combi[j].second};
                    
-                    if(check.size() == 4){
-                        hCands.push_back({jets[combi[k].first] + jets[combi[k].second], jets[combi[j].first] + jets[combi[j].second]});
+                    if(check.size() == 4 and std::abs(pairMass[k] - pairMass[j]) < minDiff){
+                        minDiff = std::abs(pairMass[k] - pairMass[j]);
+                        best = {k, j};
                     }
                 }
             }
+
+            hCand = {jets[combi[best.first].first] + jets[combi[best.first].second], jets[combi[best.second].first] + jets[combi[best.second].second]};
         }
 
         //If 2 jets and one fat jet
         else if(jets.size() >= 2 and fatJets.size() == 1){
-            for(std::pair<int, int> jetIndex: combi){
-                hCands.push_back({fatJets[0], jets[jetIndex.first] + jets[jetIndex.second]});
+            int best = 0;
+
+            for(unsigned int k = 0; k < combi.size(); ++k){
+                if(std::abs(fatJets[0].M() - pairMass[k]) < minDiff){
+                    minDiff = std::abs(fatJets[0].M() - pairMass[k]);
+                    best = k;
+                }
             }
+
+            hCand = {fatJets[0], jets[combi[best].first] + jets[combi[best].second]};
         }
 
         //If 2 fat jets
         else if(fatJets.size() == 2){
-            hCands.push_back({fatJets[0], fatJets[1]});
+            hCand = {fatJets[0], fatJets[1]};
         }
 
         //If not right jet configuration is given
         else continue;
 
-        //Sort candPairs for mass diff of jet pairs, where index 0 is the best pair
-        std::function<bool(std::pair<PolarLV, PolarLV>, std::pair<PolarLV, PolarLV>)> sortFunc = [&](std::pair<PolarLV, PolarLV> cands1, std::pair<PolarLV, PolarLV> cands2){  
-            return std::abs(cands1.first.M() - cands1.second.M()) < std::abs(cands2.first.M() - cands2.second.M());
-        };
-
-        std::sort(hCands.begin(), hCands.end(), sortFunc);
-
-        PolarLV Hc1 = hCands[0].first + W;
-        PolarLV Hc2 = hCands[0].second + W;
-
-        if(ROOT::Math::VectorUtil::DeltaPhi(hCands[0].first, W) < ROOT::Math::VectorUtil::DeltaPhi(hCands[0].second, W)){
-            values["H1_Pt"][idx] = hCands[0].first.Pt();
-            values["H1_Eta"][idx] = hCands[0].first.Eta();
-            values["H1_Phi"][idx] = hCands[0].first.Phi();
-            values["H1_Mass"][idx] = hCands[0].first.M();
-            values["H2_Pt"][idx] = hCands[0].second.Pt();
-            values["H2_Eta"][idx] = hCands[0].second.Eta();
-            values["H2_Phi"][idx] = hCands[0].second.Phi();
-            values["H2_Mass"][idx] = hCands[0].second.M();
+        PolarLV Hc1 = hCand.first + W;
+        PolarLV Hc2 = hCand.second + W;
+
+        if(MUtil::DeltaPhi(hCand.first.Phi(), W.Phi()) < MUtil::DeltaPhi(hCand.second.Phi(), W.Phi())){
+            values["H1_Pt"][idx] = hCand.first.Pt();
+            values["H1_Eta"][idx] = hCand.first.Eta();
+            values["H1_Phi"][idx] = hCand.first.Phi();
+            values["H1_Mass"][idx] = hCand.first.M();
+            values["H2_Pt"][idx] = hCand.second.Pt();
+            values["H2_Eta"][idx] = hCand.second.Eta();
+            values["H2_Phi"][idx] = hCand.second.Phi();
+            values["H2_Mass"][idx] = hCand.second.M();
             values["HPlus_Mass"][idx] = Hc1.M();
             values["HPlus_Pt"][idx] = Hc1.Pt();
             values["HPlus_Phi"][idx] = Hc1.Phi();
@@ -407,14 +415,14 @@ std::map<std::string, std::vector<float>> Extension::HReconstruction(std::shared
         }
 
         else{
-            values["H1_Pt"][idx] = hCands[0].second.Pt();
-            values["H1_Eta"][idx] = hCands[0].second.Eta();
-            values["H1_Phi"][idx] = hCands[0].second.Phi();
-            values["H1_Mass"][idx] = hCands[0].second.M();
-            values["H2_Pt"][idx] = hCands[0].first.Pt();
-            values["H2_Eta"][idx] = hCands[0].first.Eta();
-            values["H2_Phi"][idx] = hCands[0].first.Phi();
-            values["H2_Mass"][idx] = hCands[0].first.M();
+            values["H1_Pt"][idx] = hCand.second.Pt();
+            values["H1_Eta"][idx] = hCand.second.Eta();
+            values["H1_Phi"][idx] = hCand.second.Phi();
+            values["H1_Mass"][idx] = hCand.second.M();
+            values["H2_Pt"][idx] = hCand.first.Pt();
+            values["H2_Eta"][idx] = hCand.first.Eta();
+            values["H2_Phi"][idx] = hCand.first.Phi();
+            values["H2_Mass"][idx] = hCand.first.M();
             values["HPlus_Mass"][idx] = Hc2.M();
             values["HPlus_Phi"][idx] = Hc2.Phi();
             values["HPlus_Pt"][idx] = Hc2.Pt();
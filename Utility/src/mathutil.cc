@@ -1,11 +1,47 @@
 #include <ChargedAnalysis/Utility/include/mathutil.h>
 
+float MUtil::DeltaPhi(const float& phi1, const float& phi2){
+    //Branchless wrapping, phi values are expected in [-pi, pi]
+    float dPhi = std::abs(phi1 - phi2);
+
+    return dPhi > float(M_PI) ? float(2*M_PI) - dPhi : dPhi;
+}
+
 float MUtil::DeltaR(const float& eta1, const float& phi1, const float& eta2, const float& phi2){
-    return std::sqrt(std::pow(eta1 - eta2, 2) + std::pow(phi1 - phi2, 2));
+    float dEta = eta1 - eta2, dPhi = MUtil::DeltaPhi(phi1, phi2);
+
+    return std::sqrt(dEta*dEta + dPhi*dPhi);
 }
 
-float MUtil::DeltaPhi(const float& phi1, const float& phi2){
-    return std::acos(std::cos(phi1)*std::cos(phi2) + std::sin(phi1)*std::sin(phi2));
+float MUtil::InvMass(const float& pt1, const float& eta1, const float& phi1, const float& m1, const float& pt2, const float& eta2, const float& phi2, const float& m2){
+    //Computed in double, since E1*E2 - p1*p2 cancels for collinear particles
+    double p1 = pt1*std::cosh(double(eta1)), p2 = pt2*std::cosh(double(eta2));
+    double e1 = std::sqrt(p1*p1 + double(m1)*m1), e2 = std::sqrt(p2*p2 + double(m2)*m2);
+    double pDot = double(pt1)*pt2*(std::cos(double(phi1) - phi2) + std::sinh(double(eta1))*std::sinh(double(eta2)));
+
+    double m = double(m1)*m1 + double(m2)*m2 + 2*(e1*e2 - pDot);
+
+    return m > 0 ? std::sqrt(m) : 0.;
+}
+
+float MUtil::TransverseMass(const float& pt1, const float& phi1, const float& pt2, const float& phi2){
+    return std::sqrt(2*pt1*pt2*(1 - std::cos(phi1 - phi2)));
+}
+
+float MUtil::LP(const float& ptL, const float& phiL, const float& ptMet, const float& phiMet){
+    float pxW = ptL*std::cos(phiL) + ptMet*std::cos(phiMet);
+    float pyW = ptL*std::sin(phiL) + ptMet*std::sin(phiMet);
+
+    return ptL/std::sqrt(pxW*pxW + pyW*pyW)*std::cos(MUtil::DeltaPhi(phiL, std::atan2(pyW, pxW)));
+}
+
+std::array<float, 3> MUtil::Sum(const float& pt1, const float& eta1, const float& phi1, const float& pt2, const float& eta2, const float& phi2){
+    float px = pt1*std::cos(phi1) + pt2*std::cos(phi2);
+    float py = pt1*std::sin(phi1) + pt2*std::sin(phi2);
+    float pz = pt1*std::sinh(eta1) + pt2*std::sinh(eta2);
+    float pt = std::sqrt(px*px + py*py);
+
+    return {pt, std::asinh(pz/pt), std::atan2(py, px)};
 }
 
 int MUtil::RowMajIdx(const std::vector<int>& dimensions, const std::vector<int>& indeces){
@@ -42,3 +42,69 @@ int RUtil::GetLen(TLeaf* leaf, const int& entry){
     if(leaf->GetBranch()->GetReadEntry() != entry) leaf->GetBranch()->GetEntry(entry);
     return leaf->GetLen();
 }
+
+std::vector<std::pair<long long, long long>> RUtil::SplitByCluster(TTree* tree, const long long& entryStart, const long long& entryEnd, const int& nRanges){
+    //The cluster iterator keeps returning the number of entries once past the end, so clamp the range
+    long long end = std::min(entryEnd, tree->GetEntries());
+
+    //Collect all cluster boundaries inside of the range
+    std::vector<long long> boundaries;
+    TTree::TClusterIterator clusterIter = tree->GetClusterIterator(entryStart);
+    long long clusterStart;
+
+    while((clusterStart = clusterIter()) < end){
+        if(clusterStart > entryStart) boundaries.push_back(clusterStart);
+    }
+
+    //Cut at the cluster boundary closest to the ideal equal splitting
+    std::vector<std::pair<long long, long long>> ranges;
+    long long rangeStart = entryStart;
+
+    for(int i = 1; i < nRanges and !boundaries.empty(); ++i){
+        long long ideal = entryStart + i*(end - entryStart)/nRanges;
+        long long cut = *std::min_element(boundaries.begin(), boundaries.end(), [&](const long long& b1, const long long& b2){return std::abs(b1 - ideal) < std::abs(b2 - ideal);});
+
+        if(cut <= rangeStart) continue;
+
+        ranges.push_back({rangeStart, cut});
+        rangeStart = cut;
+    }
+
+    ranges.push_back({rangeStart, end});
+
+    return ranges;
+}
+
+std::vector<long long> RUtil::ClusterBoundaries(TTree* tree){
+    std::vector<long long> boundaries;
+    long long nEntries = tree->GetEntries();
+
+    TTree::TClusterIterator clusterIter = tree->GetClusterIterator(0);
+    long long clusterStart;
+
+    while((clusterStart = clusterIter()) < nEntries) boundaries.push_back(clusterStart);
+    boundaries.push_back(nEntries);
+
+    return boundaries;
+}
+
+std::vector<std::pair<long long, long long>> RUtil::SplitByClusterSize(TTree* tree, const long long& nEvents, const long long& nBytes){
+    std::vector<long long> boundaries = ClusterBoundaries(tree);
+
+    //Exact cluster sizes would need all basket headers, the average is good enough for job splitting
+    double bytesPerEntry = boundaries.back() != 0 ? double(tree->GetZipBytes())/boundaries.back() : 0.;
+
+    std::vector<std::pair<long long, long long>> ranges;
+    long long rangeStart = 0;
+
+    for(std::size_t i = 1; i < boundaries.size(); ++i){
+        long long size = boundaries[i] - rangeStart;
+
+        if((nEvents > 0 and size >= nEvents) or (nBytes > 0 and size*bytesPerEntry >= nBytes) or i == boundaries.size() - 1){
+            ranges.push_back({rangeStart, boundaries[i]});
+            rangeStart = boundaries[i];
+        }
+    }
+
+    return ranges;
+}
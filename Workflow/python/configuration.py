@@ -6,6 +6,7 @@ import copy
 import csv
 import time
 import subprocess
+import tempfile
 import glob
 import numpy as np
 from pprint import pprint
@@ -21,6 +22,29 @@ def sendToDCache(inFile, relativPath, timeOut = 1800):
 
     return command
 
+def clusterRanges(fileNames, channel, config):
+    ##Event ranges aligned to the TTree clusters of all files, computed with one call of the clustersplit executable
+    ranges = dd(list)
+
+    if not fileNames:
+        return ranges
+
+    with tempfile.TemporaryDirectory() as tmpDir:
+        outFile = "{}/ranges.csv".format(tmpDir)
+        command = ["{}/ChargedAnalysis/bin/clustersplit".format(os.environ["CHDIR"]), "--channel", channel, "--out-file", outFile, "--n-events", str(config.get("n-events", 0)), "--n-bytes", str(config.get("n-bytes", 0)), "--filenames"] + fileNames
+
+        subprocess.run(command, check = True, stdout = subprocess.DEVNULL)
+
+        ##Empty trees appear with an empty list of ranges, unreadable files do not appear at all
+        with open(outFile, "r") as f:
+            for row in csv.DictReader(f, delimiter = "\t"):
+                ranges.setdefault(row["File"], [])
+
+                if int(row["Entries"]) != 0:
+                    ranges[row["File"]].append([int(row["Start"]), int(row["End"])])
+
+    return ranges
+
 def treeread(tasks, config, channel, era, process, syst, shift, mHPlus = "200", postFix = ""):
     ##Mis.id. jets are configured together with data process, so skip here
     if process == "MisIDJ":
@@ -74,20 +98,63 @@ def treeread(tasks, config, channel, era, process, syst, shift, mHPlus = "200",
             if proc.startswith(processName) and not "_ext" in proc:
                 fileNames.append("{}/merged/{}.root".format(skimDir.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName})), proc))
 
+    if not fileNames:
+        return
+
+    ##Regions and their cuts, identical for all jobs of this process
+    regions, cuts = [], {}
+
+    for region in config.get("regions", ["Default"]):
+        cuts[region] = config["cuts"].get("all", []) + config["cuts"].get("allRegions", {}).get(region, [])
+        regions.append(region)
+
+        if channel in config["cuts"]:
+            if region in config["cuts"][channel]:
+                cuts[region].extend(config["cuts"][channel][region])
+
+            if "all" in config["cuts"][channel]:
+                cuts[region].extend(config["cuts"][channel]["all"])
+
+            if not region in config["cuts"][channel] and not "all" in config["cuts"][channel]:
+                cuts[region].extend(config["cuts"][channel])
+
+        if process in ["SingleE", "SingleMu"] and "MisIDJ" in config["processes"]:
+            lRegion = "Loose-{}".format(region)
+
+            cuts[lRegion] = [c for c in cuts[region] if not "replaceForFR" in c]
+            cuts[lRegion].extend(config["fake-estimate"]["cuts"][channel])
+            regions.append(lRegion)
+
+    ##Parameters and cuts are decoded once by writeplan, the hist jobs only read the plan file
+    planDir = config["dir"].format_map(dd(str, {"D": "Histograms", "C": channel, "E": era, "R": "Executables", "P": process, "S": systName})) + "/plan"
+
+    planTask = {
+        "name": "WritePlan_{}_{}_{}_{}_{}".format(channel, era, process, systName, postFix),
+        "executable": "writeplan",
+        "dir": planDir,
+        "run-mode": config["run-mode"],
+        "arguments": {
+            "out-file": "{}/{}.plan".format(planDir, process),
+            "parameters": parameters,
+            "regions": regions,
+            "scale-systs": scaleSysts,
+        }
+    }
+
+    for region in regions:
+        planTask["arguments"]["{}-cuts".format(region)] = cuts[region]
+
+    tasks.append(Task(planTask, "--"))
+
     nJobs = 0
+    ranges = clusterRanges(fileNames, channel, config)
 
     for fileName in fileNames:
-        try:
-            f = ROOT.TFile.Open(fileName)
-            t = f.Get(channel)   
-            nEvents = t.GetEntries()
-            f.Close()
-
-        except:
+        if not fileName in ranges:
             print("Could not read file, which is skipped: {}".format(fileName))
             continue
 
-        eventRanges = [[i if i == 0 else i+1, i+config["n-events"] if i+config["n-events"] <= nEvents else nEvents] for i in range(0, nEvents, config["n-events"])]
+        eventRanges = ranges[fileName]
 
         outDir, systDirs = {}, {}
 
@@ -99,12 +166,13 @@ def treeread(tasks, config, channel, era, process, syst, shift, mHPlus = "200",
                 "executable": "hist",
                 "dir": config["dir"].format_map(dd(str, {"D": "Histograms", "C": channel, "E": era, "R": "Executables", "P": process, "S": systName})) + "/unmerged/{}".format(nJobs),
                 "run-mode": config["run-mode"],
+                "dependencies": [planTask["name"]],
                 "arguments": {
                     "filename": fileName,
-                    "parameters": parameters,
+                    "plan": planTask["arguments"]["out-file"],
                     "out-file": "{}.root".format(process),
                     "channel": channel,
-                    "regions": [],
+                    "regions": regions,
                     "scale-systs": scaleSysts,
                     "bkg-yield-factor": bkgYldFactor,
                     "bkg-yield-factor-syst": bkgYldFactorSyst,
@@ -119,30 +187,15 @@ def treeread(tasks, config, channel, era, process, syst, shift, mHPlus = "200",
                 task["arguments"]["fake-rate"] = os.environ["CHDIR"] + "/" + config["fake-estimate"]["rates"].format_map(dd(str, {"C": "EleIncl" if "Ele" in channel else "MuonIncl", "E": era, "R": "fake", "S": systName}))
                 task["arguments"]["prompt-rate"] = os.environ["CHDIR"] + "/" + config["fake-estimate"]["rates"].format_map(dd(str, {"C": "EleIncl" if "Ele" in channel else "MuonIncl", "E": era, "R": "prompt", "S": systName}))
 
-            for region in config.get("regions", ["Default"]):
+            for region in regions:
                 task["arguments"]["{}-out-dir".format(region)] = config["dir"].format_map(dd(str, {"D": "Histograms", "C": channel, "E": era, "R": region, "P": process, "S": systName})) + "/unmerged/{}".format(nJobs)
-                task["arguments"]["{}-syst-dirs".format(region)] = [task["arguments"]["{}-out-dir".format(region)].replace(systName, "{}{}".format(scaleSyst, scaleShift)) for scaleSyst in scaleSysts for scaleShift in ["Up", "Down"]]
-                task["arguments"]["{}-cuts".format(region)] = config["cuts"].get("all", []) + config["cuts"].get("allRegions", {}).get(region, [])
-                task["arguments"]["regions"].append(region)
-
-                if channel in config["cuts"]:
-                    if region in config["cuts"][channel]:
-                        task["arguments"]["{}-cuts".format(region)].extend(config["cuts"][channel][region])
-
-                    if "all" in config["cuts"][channel]:
-                        task["arguments"]["{}-cuts".format(region)].extend(config["cuts"][channel]["all"])
-
-                    if not region in config["cuts"][channel] and not "all" in config["cuts"][channel]:
-                        task["arguments"]["{}-cuts".format(region)].extend(config["cuts"][channel])
 
-                if process in ["SingleE", "SingleMu"] and "MisIDJ" in config["processes"]:
-                    lRegion = "Loose-{}".format(region)
+                ##Loose regions of the fake estimate have no scale systematics
+                if region.startswith("Loose-"):
+                    task["arguments"]["{}-syst-dirs".format(region)] = []
 
-                    task["arguments"]["{}-out-dir".format(lRegion)] = config["dir"].format_map(dd(str, {"D": "Histograms", "C": channel, "E": era, "R": lRegion, "P": process, "S": systName})) + "/unmerged/{}".format(nJobs)
-                    task["arguments"]["{}-syst-dirs".format(lRegion)] = []
-                    task["arguments"]["{}-cuts".format(lRegion)] = [c for c in task["arguments"]["{}-cuts".format(region)] if not "replaceForFR" in c]
-                    task["arguments"]["{}-cuts".format(lRegion)].extend(config["fake-estimate"]["cuts"][channel])
-                    task["arguments"]["regions"].append(lRegion)
+                else:
+                    task["arguments"]["{}-syst-dirs".format(region)] = [task["arguments"]["{}-out-dir".format(region)].replace(systName, "{}{}".format(scaleSyst, scaleShift)) for scaleSyst in scaleSysts for scaleShift in ["Up", "Down"]]
 
             tasks.append(Task(task, "--"))
 
@@ -217,15 +270,51 @@ def treeIndex(tasks, config, channel, era, process, syst, shift, postFix = ""):
                 fileNames.append("{}/merged/{}.root".format(skimDir.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName})), proc))
                 procNames.append(proc)
         
+    if not fileNames:
+        return
+
+    ##Cuts of each region, decoded once by writeplan and read by all treeIndex jobs
+    regions = config.get("regions", ["Default"])
+    planDir = config["dir"].format_map(dd(str, {"D": "Index", "C": channel, "E": era, "R": "Executables", "P": process, "S": systName})) + "/plan"
+
+    planTask = {
+        "name": "WriteIndexPlan_{}_{}_{}_{}_{}".format(channel, era, process, systName, postFix),
+        "executable": "writeplan",
+        "dir": planDir,
+        "run-mode": config["run-mode"],
+        "arguments": {
+            "out-file": "{}/{}.plan".format(planDir, process),
+            "regions": regions,
+        }
+    }
+
+    for region in regions:
+        planTask["arguments"]["{}-cuts".format(region)] = list(config["cuts"].get("all", []))
+
+        if channel in config["cuts"]:
+            if region in config["cuts"][channel]:
+                planTask["arguments"]["{}-cuts".format(region)] += config["cuts"][channel][region]
+
+            elif "all" in config["cuts"][channel]:
+                planTask["arguments"]["{}-cuts".format(region)] += config["cuts"][channel]["all"]
+
+            else:
+                planTask["arguments"]["{}-cuts".format(region)] += config["cuts"][channel]
+
+    tasks.append(Task(planTask, "--"))
+
     nJobs = 0
+    ranges = clusterRanges(fileNames, channel, config)
 
     for procName, fileName in zip(procNames, fileNames):
-        f = ROOT.TFile.Open(fileName)
-        t = f.Get(channel)   
-        nEvents = t.GetEntries()
-        f.Close()
+        if not fileName in ranges:
+            raise RuntimeError("Problem with file: {}".format(fileName))
 
-        eventRanges = [[i if i == 0 else i+1, i+config["n-events"] if i+config["n-events"] <= nEvents else nEvents] for i in range(0, nEvents, config["n-events"])]
+        eventRanges = ranges[fileName]
+
+        if not eventRanges:
+            print("Empty tree, file is skipped: {}".format(fileName))
+            continue
 
         outDir, systDirs = {}, {}
 
@@ -237,10 +326,12 @@ def treeIndex(tasks, config, channel, era, process, syst, shift, postFix = ""):
                 "executable": "treeIndex",
                 "dir": config["dir"].format_map(dd(str, {"D": "Index", "C": channel, "E": era, "R": "Executables", "P": process, "S": systName})) + "/unmerged/{}".format(nJobs),
                 "run-mode": config["run-mode"],
+                "dependencies": [planTask["name"]],
                 "arguments": {
                     "filename": fileName,
-                    "regions": config.get("regions", ["Default"]),
-                    "out-file": fileName.split("/")[-1].replace("root", "csv"),
+                    "plan": planTask["arguments"]["out-file"],
+                    "regions": regions,
+                    "out-file": fileName.split("/")[-1].replace("root", "idx"),
                     "channel": channel,
                     "era": era,
                     "event-start": start,
@@ -248,19 +339,8 @@ def treeIndex(tasks, config, channel, era, process, syst, shift, postFix = ""):
                 }
             }
 
-            for region in config.get("regions", ["Default"]):
+            for region in regions:
                 task["arguments"]["{}-out-dir".format(region)] = config["dir"].format_map(dd(str, {"D": "Histograms", "C": channel, "E": era, "R": region, "P": process, "S": systName})) + "/unmerged/{}".format(nJobs)
-                task["arguments"]["{}-cuts".format(region)] = config["cuts"].get("all", [])
-
-                if channel in config["cuts"]:
-                    if region in config["cuts"][channel]:
-                        task["arguments"]["{}-cuts".format(region)] += config["cuts"][channel][region]
-
-                    elif "all" in config["cuts"][channel]:
-                        task["arguments"]["{}-cuts".format(region)] += config["cuts"][channel][region]
-
-                    else:
-                        task["arguments"]["{}-cuts".format(region)] += config["cuts"][channel]
 
             tasks.append(Task(task, "--"))
 
@@ -310,12 +390,12 @@ def mergeCSV(tasks, config, channel, era, process, syst, shift, postFix = ""):
 
             task = {
                 "name": "MergeCSV_{}_{}_{}_{}_{}_{}".format(channel, era, region, proc, systName, postFix),
-                "executable": "mergeCSV",
+                "executable": "mergeIndex",
                 "dir": outDir,
                 "dependencies": dependencies[proc],
                 "arguments": {
                     "input-files": inputFiles[proc][region],
-                    "out-file": "{}/{}.csv".format(outDir, proc),
+                    "out-file": "{}/{}.idx".format(outDir, proc),
                 }
             }
 
@@ -418,29 +498,23 @@ def treeappend(tasks, config, channel, era, syst, shift, postFix = ""):
     systName = "{}{}".format(syst, shift) if syst != "Nominal" else "Nominal"
 
     skimBaseDir = "{}/{}".format(os.environ["CHDIR"], config["skim-dir"].format_map(dd(str, {"C": channel, "E": era})))
+    fileNames = [fileName for fileName in os.listdir(skimBaseDir) if not ("Run2" in fileName and syst != "Nominal") and not "_ext" in fileName]
 
-    for fileName in os.listdir(skimBaseDir):
-        if "Run2" in fileName and syst != "Nominal":
-            continue
-
-        ##Ignore extensions
-        if "_ext" in fileName:
-            continue
+    ranges = clusterRanges(["{}/{}/merged/{}.root".format(os.environ["CHDIR"], config["skim-dir"].format_map(dd(str, {"C": channel, "E": era, "P": fileName, "S": systName})), fileName) for fileName in fileNames], channel, config)
 
+    for fileName in fileNames:
         nJobs = 0
 
         skimDir = "{}/{}".format(os.environ["CHDIR"], config["skim-dir"].format_map(dd(str, {"C": channel, "E": era, "P": fileName, "S": systName})))
 
-        try:
-            f = ROOT.TFile.Open("{}/merged/{}.root".format(skimDir, fileName))
-            t = f.Get(channel)   
-            nEvents = t.GetEntries()
-            f.Close()
-
-        except:
+        if not "{}/merged/{}.root".format(skimDir, fileName) in ranges:
             raise RuntimeError("Problem with file: {}/{}".format(skimDir, fileName))
 
-        eventRanges = [[i if i == 0 else i+1, i+config["n-events"] if i+config["n-events"] <= nEvents else nEvents] for i in range(0, nEvents, config["n-events"])]
+        eventRanges = ranges["{}/merged/{}.root".format(skimDir, fileName)]
+
+        if not eventRanges:
+            print("Empty tree, file is skipped: {}/{}".format(skimDir, fileName))
+            continue
 
         ##Configuration for treeread Task
         for start, end in eventRanges:
@@ -990,13 +1064,13 @@ def DNN(tasks, config, channel, era, evType, postFix = ""):
                     cls = process if process in config["classes"] else "Misc"
                           
                     classes.setdefault(cls, []).append("{}/merged/{}.root".format(skimDir.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName})), proc))
-                    classesIndex.setdefault(cls, []).append("{}/merged/{}.csv".format(indexPath.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName, "R": evType})), proc))
+                    classesIndex.setdefault(cls, []).append("{}/merged/{}.idx".format(indexPath.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName, "R": evType})), proc))
 
         for process in config["signal"]:
             for processName in processes[process]:
                 if proc.startswith(processName):
                     signals.append("{}/merged/{}.root".format(skimDir.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName})), proc))
-                    signalsIndex.append("{}/merged/{}.csv".format(indexPath.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName, "R": evType})), proc))
+                    signalsIndex.append("{}/merged/{}.idx".format(indexPath.format_map(dd(str, {"C": channel, "E": era, "P": proc, "S": systName, "R": evType})), proc))
 
     os.makedirs(outDir, exist_ok=True)
 